@@ -44,6 +44,10 @@
 SPI_HandleTypeDef hspi1;
 
 /* USER CODE BEGIN PV */
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
+#endif
 
 /* USER CODE END PV */
 
@@ -52,6 +56,9 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_SPI1_Init(void);
 /* USER CODE BEGIN PFP */
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+static void MX_DMA_Init(void);
+#endif
 
 /* USER CODE END PFP */
 
@@ -84,6 +91,10 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+  /* DMA clock must be running before HAL_SPI_MspInit links the streams */
+  MX_DMA_Init();
+#endif
 
   /* USER CODE END SysInit */
 
@@ -314,11 +325,52 @@ static void MX_GPIO_Init(void)
   HAL_GPIO_Init(MEMS_INT2_GPIO_Port, &GPIO_InitStruct);
 
   /* USER CODE BEGIN MX_GPIO_Init_2 */
+  /* NRF24 IRQ line: PB0 as falling-edge EXTI0 (overrides the plain input generated above) */
+  GPIO_InitStruct.Pin = NRF24_IRQ_PIN;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  HAL_GPIO_Init(NRF24_IRQ_PORT, &GPIO_InitStruct);
+
+  /* EXTI interrupt init*/
+  HAL_NVIC_SetPriority(EXTI0_IRQn, NRF24_IRQ_NVIC_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(EXTI0_IRQn);
 
   /* USER CODE END MX_GPIO_Init_2 */
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief  EXTI line detection callback, routes the NRF24 IRQ line to the driver
+  * @param  GPIO_Pin: Specifies the pin connected to the EXTI line
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  if (GPIO_Pin == NRF24_IRQ_PIN)
+  {
+    nrf24_irqHandler();
+  }
+}
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+/**
+  * @brief Enable DMA controller clock and the SPI1 stream interrupts
+  * @retval None
+  */
+static void MX_DMA_Init(void)
+{
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  /* DMA interrupt init: same priority as EXTI0, the NRF24 IRQ sequence goes on from the DMA completion */
+  /* DMA2_Stream0_IRQn interrupt configuration (SPI1_RX) */
+  HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, NRF24_IRQ_NVIC_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+  /* DMA2_Stream3_IRQn interrupt configuration (SPI1_TX) */
+  HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, NRF24_IRQ_NVIC_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+}
+#endif
 
 /* USER CODE END 4 */
 
@@ -22,6 +22,7 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "../../Drivers/NRF24L01p/Inc/nrf24l01p.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -57,6 +58,10 @@
 /* External variables --------------------------------------------------------*/
 
 /* USER CODE BEGIN EV */
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
+#endif
 
 /* USER CODE END EV */
 
@@ -187,7 +192,7 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  nrf24_tick();
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -199,5 +204,29 @@ void SysTick_Handler(void)
 /******************************************************************************/
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles EXTI line0 interrupt (NRF24 IRQ).
+  */
+void EXTI0_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(NRF24_IRQ_PIN);
+}
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (SPI1_RX).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi1_rx);
+}
 
+/**
+  * @brief This function handles DMA2 stream3 global interrupt (SPI1_TX).
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi1_tx);
+}
+#endif
 /* USER CODE END 1 */
@@ -2,15 +2,91 @@
 #define NRF24L01P_INC_NRF24L01P_H_
 
 // Libraries to be used
+/* NRF24_PORT_HEADER replaces HAL and CMSIS with a header of the same names (e.g. a host build with 
+a modelled chip behind HAL_SPI_TransmitReceive, GPIOx->BSRR/ODR/IDR and DWT->CYCCNT) */
+#ifdef NRF24_PORT_HEADER
+#include NRF24_PORT_HEADER
+#else
 #include "stm32f4xx_hal.h"  // HAL
 #include "stm32f407xx.h"    //CMSIS
+#endif
 #include <stdint.h>
 
 
 
+/* Single-byte registers generated from nrf24_config_t (index into nrf24_regs_t.value) */
+#define NRF24_CONFIG_REG_CONFIG       0
+#define NRF24_CONFIG_REG_EN_AA        1
+#define NRF24_CONFIG_REG_EN_RXADDR    2
+#define NRF24_CONFIG_REG_SETUP_RETR   3
+#define NRF24_CONFIG_REG_SETUP_AW     4
+#define NRF24_CONFIG_REG_RF_CH        5
+#define NRF24_CONFIG_REG_RF_SETUP     6
+#define NRF24_CONFIG_REG_RX_PW_P0     7   /* P1-P5 follow */
+#define NRF24_CONFIG_REG_RX_ADDR_P2   13  /* P3-P5 follow */
+#define NRF24_CONFIG_REG_FEATURE      17
+#define NRF24_CONFIG_REG_DYNPD        18
+#define NRF24_CONFIG_REG_COUNT        19
+
+/* Bytes of a nrf24_batch_t stream: a full nrf24_Init (STATUS clear, 19 registers, 3 addresses) takes 81 */
+#define NRF24_BATCH_SIZE              96
+
+/* Multi-byte address registers generated from nrf24_config_t (index into nrf24_regs_t.address) */
+#define NRF24_CONFIG_ADDR_RX_ADDR_P0  0
+#define NRF24_CONFIG_ADDR_RX_ADDR_P1  1
+#define NRF24_CONFIG_ADDR_TX_ADDR     2
+#define NRF24_CONFIG_ADDR_COUNT       3
+
+/* # of RX data pipes */
+#define NRF24_PIPE_COUNT              6
+
+/* Address registers hold up to 5 bytes */
+#define NRF24_ADDR_MAX_WIDTH          5
+
+/* # of most recent faults kept in the fault log (power of two) */
+#define NRF24_FAULT_LOG_SIZE          8
+
+/* Profiled regions (@NRF24_PROFILE_xx), with NRF24_USE_PROFILING */
+#define NRF24_PROFILE_WRITE_REG       0   // nrf24_writeReg
+#define NRF24_PROFILE_READ_REG        1   // nrf24_readReg
+#define NRF24_PROFILE_STANDALONE_CMD  2   // nrf24_sendStandaloneCmd
+#define NRF24_PROFILE_IRQ             3   // nrf24_irqHandler up to the event callbacks
+#define NRF24_PROFILE_SPI_FRAME       4   // every SPI frame, NSS low to high (bus occupancy)
+#define NRF24_PROFILE_COUNT           5
+
+/* Histogram bucket n counts durations of [2^n, 2^(n+1)) cycles (0 and 1 in bucket 0) */
+#define NRF24_PROFILE_BUCKETS         32
+
+/* Link quality: the moving averages weigh each new packet by 1/2^NRF24_LINK_EWMA_SHIFT */
+#define NRF24_LINK_EWMA_SHIFT         3
+
+/* Link adaptation (@NRF24_LINK_ADAPT_xx, nrf24_setLinkAdaptation), re-evaluated every NRF24_LINK_ADAPT_PERIOD packets */
+#define NRF24_LINK_ADAPT_OFF          0b00u
+#define NRF24_LINK_ADAPT_RETR         0b01u   // ARD/ARC
+#define NRF24_LINK_ADAPT_PERIOD       16
+
+/* Thresholds on the moving averages, in 1/256 */
+#define NRF24_LINK_MAX_RT_HIGH        26      // > ~10% packets hit MAX_RT: more retries
+#define NRF24_LINK_MAX_RT_LOW         3       // < ~1% packets hit MAX_RT...
+#define NRF24_LINK_RETRIES_LOW        64      // ...and < 0.25 retries per packet: fewer retries
+#define NRF24_LINK_ARC_MIN            3       // ARC is never adapted below this
+
+/* Fault identifier: @NRF24_FAULT_xx code in the upper half, source line in the lower half */
+#define NRF24_FAULT_ID(code, line)    ( ((uint32_t)(code) << 16) | ((uint32_t)(line) & 0xFFFFu) )
+#define NRF24_FAULT_ID_CODE(id)       ( (uint8_t)((id) >> 16) )
+#define NRF24_FAULT_ID_LINE(id)       ( (uint16_t)((id) & 0xFFFFu) )
+
+
+
 /* ----------------------------------------------------------- */
 /* ----------------------- Structures ------------------------ */
 /* ----------------------------------------------------------- */
+typedef struct {
+  uint8_t enable;                         // @NRF24_REG_EN_RXADDR_ERX_Px_Val
+  uint8_t auto_ack;                       // @NRF24_REG_EN_AA_ENAA_Px_Val (pipe #0: also ACK reception in TX mode)
+  uint8_t address[NRF24_ADDR_MAX_WIDTH];  // LSByte first; pipes #2-#5 only use address[0], MSBytes come from pipe #1
+} nrf24_pipe_config_t;
+
 typedef struct {
   uint8_t rx_iqr;         // @NRF24_REG_CONFIG_MASK_xx_Val
   uint8_t tx_iqr;         // @NRF24_REG_CONFIG_MASK_xx_Val
@@ -23,7 +99,14 @@ typedef struct {
   uint8_t ard;            // @NRF24_REG_SETUP_RETR_ARD_Func_Val_step250_max4000us() [TX-specific]
   uint8_t arc;            // Value between 0 and 15                                 [TX-specific]
 
-  uint8_t rf_chl;         // 6 bits(0-63) frequency channel
+  uint8_t rf_chl;         // 7 bits(0-125) frequency channel, 2400 + rf_chl MHz
+
+  uint8_t payload_width;  // 1-32 bytes, static payload length of every enabled pipe (ignored with dpl) [RX-specific]
+  uint8_t dpl;            // @NRF24_REG_FEATURE_EN_DPL_Val, must match on both ends
+  uint8_t ack_pay;        // @NRF24_REG_FEATURE_EN_ACK_PAY_Val, payloads in ACKs (requires dpl)
+
+  nrf24_pipe_config_t pipes[NRF24_PIPE_COUNT];  // [RX-specific, pipe #0 auto_ack used in TX too]
+  uint8_t tx_address[NRF24_ADDR_MAX_WIDTH];     // LSByte first, also used as RX_ADDR_P0 for ACKs [TX-specific]
 
   /* RF_SETUP is suggested to have default for everything
   beside rf_pwr and dr_high which can be set to maximum */
@@ -32,18 +115,209 @@ typedef struct {
   uint8_t pll_lock;       // @NRF24_REG_RF_SETUP_PLL_LOCK_Val                       [FOR TESTING-ONLY]
   uint8_t dr_low;         // @NRF24_REG_RF_SETUP_RF_DR_LOW_Val
   uint8_t count_wave;     // @NRF24_REG_RF_SETUP_CONT_WAVE_Val
+
+  uint8_t en_dyn_ack;     // @NRF24_REG_FEATURE_EN_DYN_ACK_Val                       [TX-specific]
 } nrf24_config_t;
 
+/* Result of the driver entry points */
+typedef enum {
+  NRF24_OK = 0,
+  NRF24_ERR_TIMEOUT,      // SPI frame did not complete within its deadline
+  NRF24_ERR_SPI,          // HAL/SPI error (overrun, DMA error, peripheral not ready)
+  NRF24_ERR_BUSY,         // SPI bus still owned after the longest possible wait
+  NRF24_ERR_FULL,         // ring, queue or batch full
+  NRF24_ERR_EMPTY,        // nothing received
+  NRF24_ERR_STATE,        // not allowed in the current power state
+  NRF24_ERR_PARAM         // size or pipe out of range, nothing was sent
+} nrf24_err_t;
+
+/* Faults recorded by the driver (@NRF24_FAULT_xx) */
+typedef enum {
+  NRF24_FAULT_ASSERT = 0,   // NRF24_ASSERT failed: invalid argument or state
+  NRF24_FAULT_SPI_TIMEOUT,  // blocking SPI frame past its deadline
+  NRF24_FAULT_SPI,          // blocking SPI frame failed (HAL error, overrun)
+  NRF24_FAULT_BUS_BUSY,     // SPI bus not released within the longest possible wait
+  NRF24_FAULT_DMA_START,    // DMA frame could not be started
+  NRF24_FAULT_DMA_ERROR,    // DMA/SPI error reported by HAL_SPI_ErrorCallback
+  NRF24_FAULT_DMA_STUCK,    // DMA frame aborted past its deadline
+  NRF24_FAULT_COUNT
+} nrf24_fault_code_t;
+
+/* Fault log entry
+id:   NRF24_FAULT_ID(code, line) of the place that raised it
+tick: HAL_GetTick() at the time */
+typedef struct {
+  uint32_t id;
+  uint32_t tick;
+} nrf24_fault_t;
+
+/* Link quality sampled from OBSERVE_TX on every TX_DS/MAX_RT (PTX)
+sent:           packets acknowledged (TX_DS)
+max_rt:         MAX_RT events: ARC retransmits went unacknowledged. Not a loss by itself, the payload
+                stays in the TX FIFO and is retried (see nrf24_irqHandler)
+retries:        sum of the retransmits of the sampled packets
+retry_samples:  packets whose retransmits are known: ARC_CNT belongs to the packet that completed only
+                if no other one was left in the TX FIFO to start in the meantime, and a MAX_RT packet used all ARC
+retries_avg:    moving average of retransmits per sampled packet, in 1/256 retries
+max_rt_avg:     moving average of MAX_RT per completed packet, in 1/256 (256 = every packet)
+plos_cnt:       last PLOS_CNT (packets that hit MAX_RT since RF_CH was written, saturates at 15) */
+typedef struct {
+  uint32_t sent;
+  uint32_t max_rt;
+  uint32_t retries;
+  uint32_t retry_samples;
+  uint16_t retries_avg;
+  uint16_t max_rt_avg;
+  uint8_t plos_cnt;
+} nrf24_link_stats_t;
+
+/* Cycles spent in a profiled region
+count:       # of runs
+min, max:    shortest/longest run
+total:       sum of all runs (mean = total / count)
+histogram[]: runs per log2 bucket, see NRF24_PROFILE_BUCKETS */
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t histogram[NRF24_PROFILE_BUCKETS];
+} nrf24_profile_t;
+
+/* Events dispatched by nrf24_irqHandler, NULL members are skipped */
+typedef struct {
+  void (*rx_ready)( uint8_t pipe );   // RX_DR: payload available, @pipe from STATUS.RX_P_NO
+  void (*tx_done)( void );            // TX_DS: payload sent (and ACKed when auto-ack is on), ACK payload already in the pipe #0 ring
+  void (*max_rt)( void );             // MAX_RT: retransmits exhausted, payload still in the TX FIFO
+} nrf24_event_callbacks_t;
+
+/* RX ring counters
+overflows:      payloads dropped because the ring was full (popped from the chip anyway)
+high_watermark: highest # of payloads waiting in the ring at once */
+typedef struct {
+  uint32_t overflows;
+  uint32_t high_watermark;
+} nrf24_rx_stats_t;
+
+/* Register image derived from nrf24_config_t
+value[]:      single-byte register values, indexed by @NRF24_CONFIG_REG_xx
+used:         bit per @NRF24_CONFIG_REG_xx, 1 = register is part of the configuration
+address[]:    address register values (LSByte first), indexed by @NRF24_CONFIG_ADDR_xx
+address_used: bit per @NRF24_CONFIG_ADDR_xx
+address_size: # of address bytes (SETUP_AW + 2) */
+typedef struct {
+  uint8_t value[NRF24_CONFIG_REG_COUNT];
+  uint32_t used;
+  uint8_t address[NRF24_CONFIG_ADDR_COUNT][NRF24_ADDR_MAX_WIDTH];
+  uint8_t address_used;
+  uint8_t address_size;
+} nrf24_regs_t;
+
+/* Register addresses of nrf24_regs_t.value[] (@NRF24_CONFIG_REG_xx) and address[] (@NRF24_CONFIG_ADDR_xx) */
+extern const uint8_t nrf24_configRegAddr[NRF24_CONFIG_REG_COUNT];
+extern const uint8_t nrf24_configAddrReg[NRF24_CONFIG_ADDR_COUNT];
+
+/* Shadow register cache counters
+hits:   accesses served from RAM (reads) or skipped because the chip already holds the value (writes)
+misses: accesses that went to the bus */
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+} nrf24_shadow_stats_t;
+
+/* Sequence of commands executed back-to-back by nrf24_batchExecute
+stream[]: entries of [size][cmd][data...], cmd and data form the SPI frame as is
+length:   # of stream bytes used
+count:    # of commands */
+typedef struct {
+  uint8_t stream[NRF24_BATCH_SIZE];
+  uint8_t length;
+  uint8_t count;
+} nrf24_batch_t;
+
+/* Completion callback of the asynchronous SPI APIs. Invoked from the SPI/DMA interrupt context
+with NRF24_OK and the STATUS byte clocked out at the start of the frame, or with the error that
+ended the frame (queued command that could not start, DMA/SPI error, stuck frame), STATUS is 0 then */
+typedef void (*nrf24_callback_t)( nrf24_err_t err, uint8_t status );
+
 
 
 
 /* ----------------------------------------------------------- */
 /* ---------------- Functions declarations ------------------- */
 /* ----------------------------------------------------------- */
-void nrf24_writeReg( uint8_t reg, uint8_t* data, uint8_t size );
-void nrf24_readReg( uint8_t reg, uint8_t* buffer, uint8_t size );
-void nrf24_sendStandaloneCmd( uint8_t cmd );
-void nrf24_Init( nrf24_config_t* nrf24_config );
+nrf24_err_t nrf24_writeReg( uint8_t reg, uint8_t* data, uint8_t size );
+nrf24_err_t nrf24_readReg( uint8_t reg, uint8_t* buffer, uint8_t size );
+nrf24_err_t nrf24_sendStandaloneCmd( uint8_t cmd );
+nrf24_err_t nrf24_getStatus( uint8_t* status );
+uint8_t nrf24_getLastStatus( void );
+nrf24_err_t nrf24_Init( nrf24_config_t* nrf24_config );
+nrf24_err_t nrf24_InitRegs( const nrf24_regs_t* regs );
+nrf24_err_t nrf24_configToRegs( nrf24_config_t* nrf24_config, nrf24_regs_t* regs );
+nrf24_err_t nrf24_Reconfigure( nrf24_config_t* old_config, nrf24_config_t* new_config, uint8_t* written );
+
+void nrf24_batchInit( nrf24_batch_t* batch );
+nrf24_err_t nrf24_batchCmd( nrf24_batch_t* batch, uint8_t cmd, uint8_t* data, uint8_t size );
+nrf24_err_t nrf24_batchWriteReg( nrf24_batch_t* batch, uint8_t reg, uint8_t* data, uint8_t size );
+nrf24_err_t nrf24_batchWriteRegCached( nrf24_batch_t* batch, uint8_t reg, uint8_t* data, uint8_t size );
+nrf24_err_t nrf24_batchExecute( nrf24_batch_t* batch );
+
+nrf24_err_t nrf24_setRole( uint8_t mode, nrf24_config_t* nrf24_config );
+
+nrf24_err_t nrf24_powerUp( void );
+nrf24_err_t nrf24_powerDown( void );
+nrf24_err_t nrf24_standby( void );
+uint8_t nrf24_isReady( void );
+nrf24_err_t nrf24_waitReady( void );
+void nrf24_tick( void );
+nrf24_err_t nrf24_getPowerState( uint8_t* state );
+
+void nrf24_registerCallbacks( nrf24_event_callbacks_t* callbacks );
+void nrf24_irqHandler( void );
+
+nrf24_err_t nrf24_receive( uint8_t* buffer, uint8_t* size, uint8_t* pipe );
+nrf24_err_t nrf24_receiveFromPipe( uint8_t pipe, uint8_t* buffer, uint8_t* size );
+uint8_t nrf24_rxAvailable( void );
+uint8_t nrf24_rxAvailableOnPipe( uint8_t pipe );
+void nrf24_getRxStats( uint8_t pipe, nrf24_rx_stats_t* stats );
+
+nrf24_err_t nrf24_transmit( uint8_t* data, uint8_t size );
+nrf24_err_t nrf24_transmitNoAck( uint8_t* data, uint8_t size );
+uint8_t nrf24_txPending( void );
+nrf24_err_t nrf24_flushTx( void );
+nrf24_err_t nrf24_writeAckPayload( uint8_t pipe, uint8_t* data, uint8_t size );
+
+nrf24_err_t nrf24_writeRegAsync( uint8_t reg, uint8_t* data, uint8_t size, nrf24_callback_t callback );
+nrf24_err_t nrf24_readRegAsync( uint8_t reg, uint8_t* buffer, uint8_t size, nrf24_callback_t callback );
+uint8_t nrf24_isBusy( void );
+
+nrf24_err_t nrf24_submitCmd( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback );
+uint8_t nrf24_cmdPending( void );
+
+nrf24_err_t nrf24_writeRegCached( uint8_t reg, uint8_t* data, uint8_t size );
+nrf24_err_t nrf24_readRegCached( uint8_t reg, uint8_t* buffer, uint8_t size );
+void nrf24_shadowInvalidate( void );
+nrf24_err_t nrf24_shadowResync( void );
+nrf24_err_t nrf24_shadowVerify( uint8_t* mismatches );
+nrf24_err_t nrf24_shadowRestore( void );
+void nrf24_getShadowStats( nrf24_shadow_stats_t* stats );
+void nrf24_resetShadowStats( void );
+
+nrf24_err_t nrf24_scanChannels( uint8_t samples, uint8_t* occupancy );
+uint8_t nrf24_quietestChannel( const uint8_t* occupancy, uint8_t first, uint8_t last );
+
+void nrf24_getLinkStats( nrf24_link_stats_t* stats );
+void nrf24_resetLinkStats( void );
+void nrf24_setLinkAdaptation( uint8_t mode );
+
+uint32_t nrf24_getFaultCount( uint8_t code );
+uint8_t nrf24_getFaults( nrf24_fault_t* faults, uint8_t max );
+void nrf24_clearFaults( void );
+
+// With NRF24_USE_PROFILING only
+void nrf24_getProfile( uint8_t region, nrf24_profile_t* profile );
+void nrf24_resetProfile( void );
+void nrf24_dumpProfile( void );
 
 
 
@@ -52,6 +326,16 @@ void nrf24_Init( nrf24_config_t* nrf24_config );
 /* ----------------------------------------------------------- */
 #define NRF24_USE_ASSERTS
 
+// On-board benchmark (nrf24l01p_bench.h), off in production builds
+// #define NRF24_USE_BENCHMARK
+
+// Cycle profiling of the SPI entry points and the IRQ handler (nrf24_dumpProfile), nothing is compiled in without it
+// #define NRF24_USE_PROFILING
+
+// Keeps the fault log across resets in a .noinit section. Needs the linker script to provide it,
+// e.g. `.noinit (NOLOAD) : { *(.noinit*) } >RAM`: without NOLOAD it becomes loadable data in the image.
+// #define NRF24_FAULT_LOG_NOINIT
+
 // Redundant copy of HAL macros
 #define GPIO_PIN_RESET  0b0u
 #define GPIO_PIN_SET    0b1u
@@ -59,6 +343,16 @@ void nrf24_Init( nrf24_config_t* nrf24_config );
 #define FALSE           0b0u
 #define TRUE            0b1u
 
+/* Shadow register cache: single-byte registers 0x00-0x1D indexed by address,
+the three 5-byte address registers (RX_ADDR_P0, RX_ADDR_P1, TX_ADDR) kept separately.
+STATUS, OBSERVE_TX, RPD and FIFO_STATUS are volatile and never cached. */
+#define NRF24_SHADOW_REG_COUNT      (NRF24_REG_FEATURE + 1)
+#define NRF24_SHADOW_ADDR_COUNT     3
+#define NRF24_SHADOW_CACHEABLE_MASK ( (0x7Fu << NRF24_REG_CONFIG) \
+                                    | (0x1FFFu << NRF24_REG_RX_ADDR_P0) \
+                                    | (0b1u << NRF24_REG_DYNPD) \
+                                    | (0b1u << NRF24_REG_FEATURE) )
+
 
 /* ----------------------------------------------------------- */
 /* ------------------ STM32F407G1-specific ------------------- */
@@ -79,11 +373,82 @@ void nrf24_Init( nrf24_config_t* nrf24_config );
 #define NRF24_IRQ_PORT 	GPIOB
 #define NRF24_IRQ_PIN 	GPIO_PIN_0
 
+/* NVIC preemption priority of the IRQ line (EXTI0). Must be numerically above TICK_INT_PRIORITY:
+the HAL SPI timeouts of the POLLING/DMA transports count SysTick ticks, a handler at the
+SysTick priority would freeze HAL_GetTick and a stuck transfer would never time out.
+With the DMA transport the SPI1 DMA streams use it too: the IRQ handler's sequence goes on
+from their completion interrupt and must not preempt (or be preempted by) EXTI0. */
+#define NRF24_IRQ_NVIC_PRIORITY	1
+
+/* BSRR words for CE/NSS: lower half sets the pin, upper half resets it */
+#define NRF24_CE_BSRR_SET     ((uint32_t)NRF24_CE_PIN)
+#define NRF24_CE_BSRR_RESET   ((uint32_t)NRF24_CE_PIN << 16U)
+#define NRF24_NSS_BSRR_SET    ((uint32_t)NRF24_NSS_PIN)
+#define NRF24_NSS_BSRR_RESET  ((uint32_t)NRF24_NSS_PIN << 16U)
+
 
 /* SPI1 Handler */ 
 extern SPI_HandleTypeDef hspi1;
 #define NRF24_SPI_HANDLER hspi1
 
+/* SPI transport
+* NRF24_SPI_TRANSPORT_POLLING:  blocking HAL_SPI_xx calls, the CPU spins for the whole transfer
+* NRF24_SPI_TRANSPORT_DMA:      HAL_SPI_xx_DMA calls on DMA2 (Stream0 = SPI1_RX, Stream3 = SPI1_TX, Channel 3)
+*                               for the asynchronous APIs, NSS is released and the callback invoked from the
+*                               DMA completion interrupt. nrf24_irqHandler moves the RX drain and TX
+*                               refill payload frames (up to 33 bytes) by DMA and returns while they
+*                               are clocked, its sequence goes on from the completion interrupt.
+*                               Synchronous calls and the short frames (STATUS, widths) stay blocking.
+* NRF24_SPI_TRANSPORT_REGISTER: blocking, drives SPIx->DR/SR directly with TXE/RXNE pipelining,
+*                               no HAL locking, state or tick bookkeeping per frame
+*/
+#define NRF24_SPI_TRANSPORT_POLLING   0
+#define NRF24_SPI_TRANSPORT_DMA       1
+#define NRF24_SPI_TRANSPORT_REGISTER  2
+
+#ifndef NRF24_SPI_TRANSPORT
+#define NRF24_SPI_TRANSPORT NRF24_SPI_TRANSPORT_POLLING
+#endif
+
+/* Clock of the bus NRF24_SPI_HANDLER sits on (SPI1: APB2), used to derive the SPI timeouts */
+#define NRF24_SPI_PCLK_FREQ()         HAL_RCC_GetPCLK2Freq()
+
+/* Slack added to every SPI frame timeout on top of twice its wire time, in us */
+#define NRF24_SPI_TIMEOUT_MARGIN_US   50
+
+/* Longest SPI frame: 1 command byte + 32 payload bytes */
+#define NRF24_MAX_PAYLOAD_SIZE  32
+#define NRF24_MAX_FRAME_SIZE    (NRF24_MAX_PAYLOAD_SIZE + 1)
+
+/* Commands queued by nrf24_submitCmd (DMA transport), power of two */
+#define NRF24_CMD_QUEUE_SIZE    8
+
+/* Passes nrf24_irqHandler makes while the IRQ line stays low before it re-triggers itself */
+#define NRF24_IRQ_MAX_PASSES    4
+
+/* Standby -> RX/TX settling time (datasheet Tstby2a), in us */
+#define NRF24_RX_SETTLING_US    130
+
+/* RF channels 0-125 (2400-2525MHz) */
+#define NRF24_CHANNEL_COUNT     126
+
+/* RX dwell per channel before RPD is valid (datasheet Tstby2a + Tdelay_AGC), in us */
+#define NRF24_RPD_DWELL_US      170
+
+/* Power-down -> Standby-I start-up time (datasheet Tpd2stby with a crystal of Ls < 90mH), in us */
+#define NRF24_POWER_UP_US       1500
+
+/* @NRF24_POWER_STATE - states of the chip's state machine */
+#define NRF24_POWER_STATE_POWER_DOWN  0
+#define NRF24_POWER_STATE_STANDBY_I   1
+#define NRF24_POWER_STATE_STANDBY_II  2
+#define NRF24_POWER_STATE_RX          3
+#define NRF24_POWER_STATE_TX          4
+
+/* Payload rings (TX and one RX ring per pipe) between nrf24_irqHandler and the application,
+# of 32-byte slots per ring (power of two) */
+#define NRF24_RING_SIZE         16
+
 
 
 /* ----------------------------------------------------------- */
@@ -100,6 +465,7 @@ extern SPI_HandleTypeDef hspi1;
 #define R_RX_PAYLOAD  0x61
 #define W_TX_PAYLOAD  0xA0
 #define W_ACK_PAYLOAD 0xA8
+#define W_TX_PAYLOAD_NOACK 0xB0
 #define FLUSH_TX      0xE1
 #define FLUSH_RX      0xE2
 #define REUSE_TX_PL   0xE3
@@ -208,12 +574,19 @@ extern SPI_HandleTypeDef hspi1;
 #define NRF24_REG_SETUP_RETR_ARC_Pos      0
 #define NRF24_REG_SETUP_RETR_ARD_Pos      4
 
+// Masks
+#define NRF24_REG_SETUP_RETR_xx_Msk       0b1111u
+
 // Values
 /* Number of re-transmits on fail can be set directly. 
 e.g., 3 = 3 re-transmits on fail. */
 #define NRF24_REG_SETUP_RETR_ARC_Val_DISABLE                        0b0000u
 
-#define NRF24_REG_SETUP_RETR_ARD_Func_Val_step250_max4000us(value)  (int(value/250)-1)
+/* ARD field from a delay in us (250-4000, step 250). Out-of-range delays are clamped,
+NRF24_STATIC_SETUP_RETR rejects them at compile time instead. */
+#define NRF24_REG_SETUP_RETR_ARD_Func_Val_step250_max4000us(value)  ( (uint8_t)( ((value) < 250u) ? 0u \
+                                                                    : ((value) > 4000u) ? 15u \
+                                                                    : ((value) / 250u) - 1u ) )
 
 
 /* ---------------- RF_CH (0x05) ---------------- */
@@ -276,12 +649,21 @@ e.g., 3 = 3 re-transmits on fail. */
 #define NRF24_REG_STATUS_TX_DS_Val_CLEAR              0b1u
 #define NRF24_REG_STATUS_RX_DR_Val_CLEAR              0b1u
 
+// Masks
+#define NRF24_REG_STATUS_RX_P_NO_Msk                  0b111u
+#define NRF24_STATUS_IRQ_MASK                         ( (NRF24_REG_STATUS_RX_DR_Val_CLEAR << NRF24_REG_STATUS_RX_DR_Pos) \
+                                                      | (NRF24_REG_STATUS_TX_DS_Val_CLEAR << NRF24_REG_STATUS_TX_DS_Pos) \
+                                                      | (NRF24_REG_STATUS_MAX_RT_Val_CLEAR << NRF24_REG_STATUS_MAX_RT_Pos) )
+
 
 /* ---------------- OBSERVE_TX (0x08) ---------------- */
 // Positions
 #define NRF24_REG_OBSERVE_TX_ARC_CNT_Pos  0 /* [3:0] */
 #define NRF24_REG_OBSERVE_TX_PLOS_CNT_Pos 4 /* [7:4] */
 
+// Masks
+#define NRF24_REG_OBSERVE_TX_CNT_Msk      0b1111u
+
 
 /* ---------------- RPD (0x09) ---------------- */
 // Positions
@@ -322,9 +704,138 @@ e.g., 3 = 3 re-transmits on fail. */
 
 
 /* ---------------- FEATURE (0x1D) ---------------- */
+// Positions
 #define NRF24_REG_FEATURE_EN_DYN_ACK_Pos  0
 #define NRF24_REG_FEATURE_EN_ACK_PAY_Pos  1
 #define NRF24_REG_FEATURE_EN_DPL_Pos      2
 /* bits7:3 reserved */
 
+// Values
+#define NRF24_REG_FEATURE_EN_DYN_ACK_Val_DISABLE  0b0u
+#define NRF24_REG_FEATURE_EN_DYN_ACK_Val_ENABLE   0b1u
+
+#define NRF24_REG_FEATURE_EN_ACK_PAY_Val_DISABLE  0b0u
+#define NRF24_REG_FEATURE_EN_ACK_PAY_Val_ENABLE   0b1u
+
+#define NRF24_REG_FEATURE_EN_DPL_Val_DISABLE      0b0u
+#define NRF24_REG_FEATURE_EN_DPL_Val_ENABLE       0b1u
+
+
+
+/* ----------------------------------------------------------- */
+/* ------------------ Static configuration ------------------- */
+/* ----------------------------------------------------------- */
+/* Compile-time counterpart of nrf24_config_t: every macro below is an integer constant expression
+that fails to compile on an illegal setting, so a const nrf24_regs_t built from them is checked
+by the compiler and placed in flash ready to be written by nrf24_InitRegs.
+
+e.g. a PTX on channel 76, 2Mbps, 500us x 5 retransmits:
+static const nrf24_regs_t ptx = {
+  .value = {
+    [NRF24_CONFIG_REG_CONFIG]     = NRF24_STATIC_CONFIG( NRF24_REG_CONFIG_PRIM_RX_Val_PTX, NRF24_REG_CONFIG_EN_CRC_Val_ENABLE, 0, 0, 0 ),
+    [NRF24_CONFIG_REG_EN_AA]      = NRF24_STATIC_PIPE_MASK( 0b000001u ),
+    [NRF24_CONFIG_REG_EN_RXADDR]  = NRF24_STATIC_PIPE_MASK( 0b000001u ),
+    [NRF24_CONFIG_REG_SETUP_RETR] = NRF24_STATIC_SETUP_RETR( 500, 5 ),
+    [NRF24_CONFIG_REG_RX_PW_P0]   = NRF24_STATIC_RX_PW( 32 ),
+    [NRF24_CONFIG_REG_SETUP_AW]   = NRF24_STATIC_SETUP_AW( NRF24_REG_SETUP_AW_Val_5BYTES ),
+    [NRF24_CONFIG_REG_RF_CH]      = NRF24_STATIC_RF_CH( 76 ),
+    [NRF24_CONFIG_REG_RF_SETUP]   = NRF24_STATIC_RF_SETUP( NRF24_REG_RF_SETUP_RF_PWR_Val_0dBm, NRF24_REG_RF_SETUP_RF_DR_HIGH_Val_2MBPS, NRF24_REG_RF_SETUP_RF_DR_LOW_Val_RESET ),
+    [NRF24_CONFIG_REG_FEATURE]    = NRF24_STATIC_FEATURE( 0, 0, 0 ),
+    [NRF24_CONFIG_REG_DYNPD]      = NRF24_STATIC_DYNPD( 0, 0b000001u ),
+  },
+  .used = NRF24_STATIC_USED_PTX,
+  .address = {
+    [NRF24_CONFIG_ADDR_RX_ADDR_P0] = { 0xE7, 0xE7, 0xE7, 0xE7, 0xE7 },
+    [NRF24_CONFIG_ADDR_TX_ADDR]    = { 0xE7, 0xE7, 0xE7, 0xE7, 0xE7 },
+  },
+  .address_used = NRF24_STATIC_ADDR_USED_PTX,
+  .address_size = NRF24_STATIC_ADDRESS_SIZE( NRF24_REG_SETUP_AW_Val_5BYTES ),
+}; */
+
+// 0 if @expr holds, compile error otherwise (C11 allows _Static_assert among struct members)
+#define NRF24_STATIC_CHECK(expr)      ( 0u * sizeof(struct { _Static_assert( (expr), #expr ); uint8_t nrf24_check; }) )
+
+#define NRF24_STATIC_BIT(value)       ( (value) == 0u || (value) == 1u )
+
+// CONFIG: PWR_UP set, 1-byte CRC as nrf24_Init
+#define NRF24_STATIC_CONFIG(mode, en_crc, rx_iqr, tx_iqr, max_rt_iqr) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( NRF24_STATIC_BIT(mode) && NRF24_STATIC_BIT(en_crc) ) \
+             + NRF24_STATIC_CHECK( NRF24_STATIC_BIT(rx_iqr) && NRF24_STATIC_BIT(tx_iqr) && NRF24_STATIC_BIT(max_rt_iqr) ) \
+             + (NRF24_REG_CONFIG_PWR_UP_Val_UP << NRF24_REG_CONFIG_PWR_UP_Pos) \
+             + ((mode) << NRF24_REG_CONFIG_PRIM_RX_Pos) \
+             + ((en_crc) << NRF24_REG_CONFIG_EN_CRC_Pos) \
+             + ((max_rt_iqr) << NRF24_REG_CONFIG_MASK_MAX_RT_Pos) \
+             + ((tx_iqr) << NRF24_REG_CONFIG_MASK_TX_DS_Pos) \
+             + ((rx_iqr) << NRF24_REG_CONFIG_MASK_RX_DR_Pos) ) )
+
+// EN_AA, EN_RXADDR: bit per pipe
+#define NRF24_STATIC_PIPE_MASK(mask) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (mask) <= 0b111111u ) + (mask) ) )
+
+#define NRF24_STATIC_SETUP_AW(width) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (width) != NRF24_REG_SETUP_AW_Val_ILLEGAL && (width) <= NRF24_REG_SETUP_AW_Val_5BYTES ) \
+             + ((width) << NRF24_REG_SETUP_AW_Pos) ) )
+
+// nrf24_regs_t.address_size
+#define NRF24_STATIC_ADDRESS_SIZE(width) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (width) != NRF24_REG_SETUP_AW_Val_ILLEGAL && (width) <= NRF24_REG_SETUP_AW_Val_5BYTES ) \
+             + (width) + 2u ) )
+
+// SETUP_RETR: @ard_us 250-4000us in steps of 250us, @arc 0-15 retransmits
+#define NRF24_STATIC_SETUP_RETR(ard_us, arc) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (ard_us) >= 250u && (ard_us) <= 4000u && (ard_us) % 250u == 0u ) \
+             + NRF24_STATIC_CHECK( (arc) <= 15u ) \
+             + (NRF24_REG_SETUP_RETR_ARD_Func_Val_step250_max4000us(ard_us) << NRF24_REG_SETUP_RETR_ARD_Pos) \
+             + ((arc) << NRF24_REG_SETUP_RETR_ARC_Pos) ) )
+
+#define NRF24_STATIC_RF_CH(channel) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (channel) <= 125u ) + ((channel) << NRF24_REG_RF_CH_RF_CH_Pos) ) )
+
+// RF_SETUP: 250kbps is @dr_low set with @dr_high 1Mbps, both set is reserved. No PLL lock/carrier test modes.
+#define NRF24_STATIC_RF_SETUP(rf_pwr, dr_high, dr_low) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (rf_pwr) <= NRF24_REG_RF_SETUP_RF_PWR_Val_0dBm ) \
+             + NRF24_STATIC_CHECK( NRF24_STATIC_BIT(dr_high) && NRF24_STATIC_BIT(dr_low) && !((dr_high) && (dr_low)) ) \
+             + ((rf_pwr) << NRF24_REG_RF_SETUP_RF_PWR_Pos) \
+             + ((dr_high) << NRF24_REG_RF_SETUP_RF_DR_HIGH_Pos) \
+             + ((dr_low) << NRF24_REG_RF_SETUP_RF_DR_LOW_Pos) ) )
+
+// RX_PW_Px: static payload width 1-32
+#define NRF24_STATIC_RX_PW(width) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( (width) >= 1u && (width) <= NRF24_MAX_PAYLOAD_SIZE ) \
+             + ((width) << NRF24_REG_RX_PW_PX_LEN_Pos) ) )
+
+// FEATURE: ACK payloads need dynamic payload length
+#define NRF24_STATIC_FEATURE(dpl, ack_pay, en_dyn_ack) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( NRF24_STATIC_BIT(dpl) && NRF24_STATIC_BIT(ack_pay) && NRF24_STATIC_BIT(en_dyn_ack) ) \
+             + NRF24_STATIC_CHECK( !(ack_pay) || (dpl) ) \
+             + ((en_dyn_ack) << NRF24_REG_FEATURE_EN_DYN_ACK_Pos) \
+             + ((ack_pay) << NRF24_REG_FEATURE_EN_ACK_PAY_Pos) \
+             + ((dpl) << NRF24_REG_FEATURE_EN_DPL_Pos) ) )
+
+// DYNPD: dynamic length on every auto-ACKed pipe when @dpl is set (as nrf24_Init)
+#define NRF24_STATIC_DYNPD(dpl, auto_ack_mask) \
+  ( (uint8_t)( NRF24_STATIC_CHECK( NRF24_STATIC_BIT(dpl) && (auto_ack_mask) <= 0b111111u ) \
+             + ((dpl) ? (auto_ack_mask) : 0u) ) )
+
+// nrf24_regs_t.used / address_used of a PTX (RX_PW_P0 for a later nrf24_setRole to PRX)
+#define NRF24_STATIC_USED_PTX         ( (0b1u << NRF24_CONFIG_REG_CONFIG) | (0b1u << NRF24_CONFIG_REG_EN_AA) \
+                                      | (0b1u << NRF24_CONFIG_REG_EN_RXADDR) | (0b1u << NRF24_CONFIG_REG_SETUP_RETR) \
+                                      | (0b1u << NRF24_CONFIG_REG_SETUP_AW) | (0b1u << NRF24_CONFIG_REG_RF_CH) \
+                                      | (0b1u << NRF24_CONFIG_REG_RF_SETUP) | (0b1u << NRF24_CONFIG_REG_FEATURE) \
+                                      | (0b1u << NRF24_CONFIG_REG_DYNPD) | (0b1u << NRF24_CONFIG_REG_RX_PW_P0) )
+#define NRF24_STATIC_ADDR_USED_PTX    ( (0b1u << NRF24_CONFIG_ADDR_RX_ADDR_P0) | (0b1u << NRF24_CONFIG_ADDR_TX_ADDR) )
+
+// nrf24_regs_t.used / address_used of a PRX with the pipes of @pipe_mask enabled (SETUP_RETR for a later nrf24_setRole to PTX)
+#define NRF24_STATIC_USED_PRX(pipe_mask)  ( NRF24_STATIC_CHECK( (pipe_mask) <= 0b111111u ) \
+                                          | (0b1u << NRF24_CONFIG_REG_CONFIG) | (0b1u << NRF24_CONFIG_REG_EN_AA) \
+                                          | (0b1u << NRF24_CONFIG_REG_EN_RXADDR) | (0b1u << NRF24_CONFIG_REG_SETUP_AW) \
+                                          | (0b1u << NRF24_CONFIG_REG_RF_CH) | (0b1u << NRF24_CONFIG_REG_RF_SETUP) \
+                                          | (0b1u << NRF24_CONFIG_REG_FEATURE) | (0b1u << NRF24_CONFIG_REG_DYNPD) \
+                                          | (0b1u << NRF24_CONFIG_REG_SETUP_RETR) \
+                                          | ((uint32_t)(pipe_mask) << NRF24_CONFIG_REG_RX_PW_P0) \
+                                          | ((uint32_t)((pipe_mask) >> 2) << NRF24_CONFIG_REG_RX_ADDR_P2) )
+// RX_ADDR_P1 also when only the pipes #2-#5 are enabled: they share its MSBytes
+#define NRF24_STATIC_ADDR_USED_PRX(pipe_mask) ( (uint8_t)( ((pipe_mask) & 0b1u) \
+                                              | (((pipe_mask) & 0b111110u) ? (0b1u << NRF24_CONFIG_ADDR_RX_ADDR_P1) : 0u) ) )
+
 #endif // NRF24L01P_INC_NRF24L01P_H_
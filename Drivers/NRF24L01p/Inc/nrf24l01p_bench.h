@@ -0,0 +1,134 @@
+#ifndef NRF24L01P_INC_NRF24L01P_BENCH_H_
+#define NRF24L01P_INC_NRF24L01P_BENCH_H_
+
+/*
+ * On-board benchmark of the NRF24L01 library (compiled with NRF24_USE_BENCHMARK)
+ * The board runs as PTX against a peer in PRX mode with auto-ack on the same channel/address and
+ * data rate, results are printed as CSV lines through printf (retarget __io_putchar to a UART/SWO).
+ * The peer is not told about the run: for every payload size to get through both sides need
+ * dynamic payload length, without it only the configured payload_width is measured.
+ * The SPI load and IRQ cycles columns need NRF24_USE_PROFILING (0 otherwise); it resets the profile statistics.
+ * nrf24_benchRequests compares the two ways of answering a request: in the ACK payload or after a
+ * role switch. It needs the peer running nrf24_benchResponder, which also serves as the peer of nrf24_benchSweep.
+ * The host tests run it against the simulated peer (Test/test_bench.c).
+ */
+
+#include "nrf24l01p.h"
+
+#ifdef NRF24_USE_BENCHMARK
+
+/* # of round-trip samples kept per run for the percentiles */
+#define NRF24_BENCH_MAX_SAMPLES       256
+
+/* Longest wait for TX_DS/MAX_RT of a single packet, in ms */
+#define NRF24_BENCH_PACKET_TIMEOUT_MS 100
+
+/* # of PTX -> PRX -> PTX turnarounds averaged per run */
+#define NRF24_BENCH_ROLE_SWITCHES     16
+
+/* # of register accesses timed by nrf24_benchCommands */
+#define NRF24_BENCH_COMMANDS          64
+
+/* Request/response messages: first byte of the payload, the second is the request's sequence #.
+Data payloads of nrf24_benchRun keep the MSBit clear */
+#define NRF24_BENCH_MSG_ACK           0x80    // request answered by the ACK payload / that answer
+#define NRF24_BENCH_MSG_REPLY         0x81    // request answered after a role switch / that reply
+#define NRF24_BENCH_REQUEST_SIZE      2
+#define NRF24_BENCH_REPLY_SIZE        8
+
+/* Data rates (@NRF24_BENCH_DR_xx) */
+#define NRF24_BENCH_DR_250KBPS        0
+#define NRF24_BENCH_DR_1MBPS          1
+#define NRF24_BENCH_DR_2MBPS          2
+#define NRF24_BENCH_DR_COUNT          3
+
+/* Result of one nrf24_benchRun
+Start-up (shadow copy invalidated first, so every register is written):
+  init_us:            nrf24_InitRegs of @config's register image: one batched bus ownership,
+                      CONFIG read and STATUS clear included
+  init_frames:        SPI frames nrf24_InitRegs issued, with NRF24_USE_PROFILING
+  init_reg_us:        the same register image written one nrf24_writeReg at a time
+  init_reg_frames:    SPI frames of that loop, with NRF24_USE_PROFILING
+Throughput phase (payloads streamed through the TX ring):
+  sent, acked, lost:  payloads queued, acknowledged (TX_DS), dropped after MAX_RT
+  elapsed_us:         first queued to last TX_DS/MAX_RT
+  pps, goodput_bps:   acknowledged payloads/s and payload bits/s
+  submit_cycles:      mean CPU cycles of the nrf24_transmit call that queued a payload (retries on a full ring excluded)
+  irq_cycles:         mean CPU cycles of nrf24_irqHandler (NRF24_PROFILE_IRQ) per acknowledged payload, with NRF24_USE_PROFILING
+  spi_load_permille:  share of elapsed_us the SPI bus spent in frames (NSS low), with NRF24_USE_PROFILING
+Latency phase (one payload at a time):
+  rtt_xx_us:          nrf24_transmit to TX_DS (payload on air + ACK back), percentiles and max
+Role switch (nrf24_setRole, mean of NRF24_BENCH_ROLE_SWITCHES):
+  to_prx_us:          PTX -> PRX, RX settling included
+  to_ptx_us:          PRX -> PTX (Standby-I, CE is raised by the next nrf24_transmit) */
+typedef struct {
+  uint8_t data_rate;
+  uint8_t size;
+  uint32_t init_us;
+  uint32_t init_frames;
+  uint32_t init_reg_us;
+  uint32_t init_reg_frames;
+  uint32_t sent;
+  uint32_t acked;
+  uint32_t lost;
+  uint32_t elapsed_us;
+  uint32_t pps;
+  uint32_t goodput_bps;
+  uint32_t submit_cycles;
+  uint32_t irq_cycles;
+  uint32_t spi_load_permille;
+  uint32_t rtt_p50_us;
+  uint32_t rtt_p90_us;
+  uint32_t rtt_p99_us;
+  uint32_t rtt_max_us;
+  uint32_t to_prx_us;
+  uint32_t to_ptx_us;
+} nrf24_bench_result_t;
+
+/* Result of nrf24_benchCommands, CPU cycles per call of the compiled NRF24_SPI_TRANSPORT
+(build once per transport to compare them)
+  write_reg_xx:       nrf24_writeReg of one byte (NRF24_PROFILE_WRITE_REG), fastest and mean, with NRF24_USE_PROFILING
+  read_reg_xx:        nrf24_readReg of one byte (NRF24_PROFILE_READ_REG), fastest and mean, with NRF24_USE_PROFILING
+  nss_bsrr_cycles:    NSS low then high as the driver does it (one BSRR store per edge), loop included
+  nss_hal_cycles:     the same pair through HAL_GPIO_WritePin, loop included */
+typedef struct {
+  uint8_t transport;
+  uint32_t write_reg_min;
+  uint32_t write_reg_mean;
+  uint32_t read_reg_min;
+  uint32_t read_reg_mean;
+  uint32_t nss_bsrr_cycles;
+  uint32_t nss_hal_cycles;
+} nrf24_bench_cmd_result_t;
+
+/* Result of nrf24_benchRequests, requests lost or left unanswered are not sampled
+  requests:           requests sent per answer type
+  ack_replies:        answers received in the ACK payload
+  ack_rtt_xx_us:      nrf24_transmit of the request to the ACK payload in the pipe #0 ring, median and max
+  role_replies:       answers received after the role switch
+  role_rtt_xx_us:     nrf24_transmit of the request, nrf24_setRole(PRX) on its TX_DS, to the reply
+                      in the pipe #0 ring, median and max */
+typedef struct {
+  uint8_t data_rate;
+  uint32_t requests;
+  uint32_t ack_replies;
+  uint32_t ack_rtt_p50_us;
+  uint32_t ack_rtt_max_us;
+  uint32_t role_replies;
+  uint32_t role_rtt_p50_us;
+  uint32_t role_rtt_max_us;
+} nrf24_bench_req_result_t;
+
+nrf24_err_t nrf24_benchCommands( nrf24_bench_cmd_result_t* result );
+void nrf24_benchPrintCommands( nrf24_bench_cmd_result_t* result );
+nrf24_err_t nrf24_benchRequests( nrf24_config_t* config, uint32_t requests, nrf24_bench_req_result_t* result );
+void nrf24_benchPrintRequests( nrf24_bench_req_result_t* result );
+nrf24_err_t nrf24_benchResponder( nrf24_config_t* config, uint32_t requests );
+nrf24_err_t nrf24_benchRun( nrf24_config_t* config, uint8_t data_rate, uint8_t size, uint32_t packets, nrf24_bench_result_t* result );
+void nrf24_benchSweep( nrf24_config_t* config, uint32_t packets );
+void nrf24_benchPrintHeader( void );
+void nrf24_benchPrint( nrf24_bench_result_t* result );
+
+#endif // NRF24_USE_BENCHMARK
+
+#endif // NRF24L01P_INC_NRF24L01P_BENCH_H_
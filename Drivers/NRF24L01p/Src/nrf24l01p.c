@@ -9,163 +9,2993 @@
 
 /* Header file */
 #include "../Inc/nrf24l01p.h"
+#include <string.h>
+#ifdef NRF24_USE_PROFILING
+#include <stdio.h>
+#endif
+
+
+/* --- Fault reporting --- */
+// The fault id is folded from the code and __LINE__ by the preprocessor: recording it is a couple
+// of stores and two LDREX/STREX increments, so it stays enabled in release builds.
+#define NRF24_ERROR(code)		centralized_errorHandler( NRF24_FAULT_ID((code), __LINE__) )
+
+#ifdef NRF24_USE_ASSERTS
+#define NRF24_ASSERT(expr)	do { if( !(expr) ){ NRF24_ERROR( NRF24_FAULT_ASSERT ); } } while( 0 )
+#else
+#define NRF24_ASSERT(expr)	((void)0)
+#endif
+
+// Guards an index or size: compiled in regardless of NRF24_USE_ASSERTS, the fault is logged
+// and the caller returns @ret (left empty in void functions) before anything is accessed
+#define NRF24_ASSERT_RETURN(expr, ret)	do { if( !(expr) ){ NRF24_ERROR( NRF24_FAULT_ASSERT ); return ret; } } while( 0 )
+
+
+/* --- Profiling --- */
+// BEGIN opens a region in the current block, END closes it: both vanish without NRF24_USE_PROFILING
+#ifdef NRF24_USE_PROFILING
+#define NRF24_PROFILE_BEGIN()				uint32_t nrf24_profileStart = nrf24_cycles()
+#define NRF24_PROFILE_END(region)		nrf24_profileRecord( (region), nrf24_cycles() - nrf24_profileStart )
+#else
+#define NRF24_PROFILE_BEGIN()
+#define NRF24_PROFILE_END(region)		((void)0)
+#endif
+
+
+/* --- Local functions --- */
+static void centralized_errorHandler( uint32_t id );
+static nrf24_err_t nrf24_transfer( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size );
+static nrf24_err_t nrf24_transferLocked( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size );
+static void nrf24_shadowStore( uint8_t reg, uint8_t* data, uint8_t size );
+static void nrf24_shadowForget( uint8_t reg );
+static void nrf24_shadowFrameDone( uint8_t* frame, uint8_t length, uint8_t done );
+static uint8_t nrf24_shadowMatches( uint8_t reg, uint8_t* data, uint8_t size );
+static void nrf24_txStart( void );
+static void nrf24_linkSample( uint8_t status );
+static void nrf24_irqRun( nrf24_err_t err );
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+static nrf24_err_t nrf24_startFrame( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback );
+static nrf24_err_t nrf24_dmaFrameLocked( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback );
+static nrf24_err_t nrf24_startFrameLocked( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback );
+static void nrf24_abortStuckFrame( void );
+static void nrf24_cmdQueuePump( void );
+#endif
+
+
+/* --- Transport state --- */
+// Every command is a single full-duplex frame: command + data out, STATUS + reply in.
+// Frames must live in SRAM1/2 (not CCM) to be reachable by DMA2
+static uint8_t nrf24_txFrame[NRF24_MAX_FRAME_SIZE];
+static uint8_t nrf24_rxFrame[NRF24_MAX_FRAME_SIZE];
+
+// Bus ownership: set while a frame (or the IRQ handler's sequence of frames) owns the SPI bus
+static volatile uint8_t nrf24_spiBusy = FALSE;
+
+// The IRQ line fired while the bus was owned, the handler is re-triggered on release
+static volatile uint8_t nrf24_irqPending = FALSE;
+
+// The handler could not read or clear STATUS, nrf24_tick re-triggers it
+static volatile uint8_t nrf24_irqRetry = FALSE;
+
+// STATUS clocked out at the start of the last completed frame
+static volatile uint8_t nrf24_lastStatus;
+
+// Duration of one SPI byte in DWT cycles, derived by nrf24_Init from the SPI prescaler and the APB clock
+static uint32_t nrf24_spiByteCycles = 0;
+
+// Application event callbacks dispatched by nrf24_irqHandler
+static nrf24_event_callbacks_t nrf24_eventCallbacks;
+
+
+/* --- Power state --- */
+// Start of the last Power-down -> Standby-I transition (Tpd2stby), cycle counter and HAL tick
+static uint32_t nrf24_wakeCycles;
+static uint32_t nrf24_wakeTick;
+
+// A Power-down -> Standby-I transition has not been observed as complete yet
+static uint8_t nrf24_waking = FALSE;
+
+
+/* --- Payload rings --- */
+// Single-producer/single-consumer ring of payload slots. head is only written by the producer,
+// tail only by the consumer, both are free-running so (head - tail) is the fill level.
+typedef struct {
+	uint8_t data[NRF24_RING_SIZE][NRF24_MAX_PAYLOAD_SIZE] __ALIGNED(32);
+	uint8_t size[NRF24_RING_SIZE];
+	uint8_t pipe[NRF24_RING_SIZE];
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t overflows;
+	uint32_t high_watermark;
+} nrf24_ring_t;
+
+_Static_assert( (NRF24_RING_SIZE & (NRF24_RING_SIZE - 1)) == 0, "NRF24_RING_SIZE must be a power of two" );
+
+// Received payloads, one ring per pipe: produced by nrf24_irqHandler, consumed by nrf24_receive*
+static nrf24_ring_t nrf24_rxRing[NRF24_PIPE_COUNT] __ALIGNED(32);
+
+// Payloads to be sent: produced by nrf24_transmit, consumed by nrf24_irqHandler
+// (pipe[] holds the TX command used to load the payload)
+static nrf24_ring_t nrf24_txRing __ALIGNED(32);
+
+// Set while CE is held high to stream the TX FIFO out
+static uint8_t nrf24_txStreaming = FALSE;
+
+// Set while the TX FIFO holds payloads but CE waits for the Tpd2stby start-up (see nrf24_tick)
+static volatile uint8_t nrf24_txDeferred = FALSE;
+
+
+/* --- IRQ sequence --- */
+// Stages of nrf24_irqRun (@NRF24_IRQ_STAGE)
+#define NRF24_IRQ_STAGE_STATUS    0   // read STATUS, clear the flags seen, sample the link
+#define NRF24_IRQ_STAGE_RX        1   // read the payload RX_P_NO points at
+#define NRF24_IRQ_STAGE_RX_DONE   2   // payload read finished
+#define NRF24_IRQ_STAGE_TX        3   // load the next payload of nrf24_txRing (PTX)
+#define NRF24_IRQ_STAGE_TX_DONE   4   // payload write finished
+#define NRF24_IRQ_STAGE_TX_END    5   // deferred CE start, back to Standby-I once everything left
+#define NRF24_IRQ_STAGE_DISPATCH  6   // release the bus, invoke the callbacks, check the line again
+
+// Where nrf24_irqRun resumes after a payload frame and what the pass collected so far.
+// Only touched by the bus owner.
+typedef struct {
+	uint8_t stage;				// @NRF24_IRQ_STAGE
+	uint8_t pass;					// passes made while the IRQ line stayed low
+	uint8_t status;				// STATUS read at the start of the pass (events to dispatch)
+	uint8_t fifo;					// STATUS of the last frame (RX_P_NO, TX_FULL)
+	uint8_t rx_pipes;			// bit per pipe that received at least one payload
+	uint8_t pipe;					// pipe of the payload being read
+	uint8_t width;				// and its width
+	uint8_t to_ring;			// TRUE = read into the pipe's ring, FALSE = discarded (ring full)
+	uint32_t cycles;			// CPU cycles of the pass before its last resumption
+} nrf24_irq_t;
+
+static nrf24_irq_t nrf24_irq = { NRF24_IRQ_STAGE_STATUS };
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+// Start (DWT cycles) and length of the DMA frame in flight, for the stuck-frame watchdog
+static volatile uint32_t nrf24_frameStart;
+static volatile uint8_t nrf24_frameLength;
+
+// Where to copy the received bytes and who to notify once the frame is done
+static uint8_t* nrf24_pendingBuffer;
+static uint8_t nrf24_pendingSize;
+static nrf24_callback_t nrf24_pendingCallback;
+
+// The frame in flight is a payload frame of the IRQ sequence: its completion keeps the bus
+// and resumes nrf24_irqRun
+static volatile uint8_t nrf24_pendingIrq = FALSE;
+
+/* --- Command queue --- */
+// Multi-producer/single-consumer queue of commands executed from the SPI/DMA completion.
+// Producers reserve a slot by advancing reserve with LDREX/STREX and publish it with ready,
+// the consumer is whoever owns the bus (so there is only one at a time) and advances tail.
+typedef struct {
+	uint8_t cmd;
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size;
+	uint8_t* buffer;
+	nrf24_callback_t callback;
+	volatile uint8_t ready;
+} nrf24_cmd_t;
+
+_Static_assert( (NRF24_CMD_QUEUE_SIZE & (NRF24_CMD_QUEUE_SIZE - 1)) == 0, "NRF24_CMD_QUEUE_SIZE must be a power of two" );
+
+static nrf24_cmd_t nrf24_cmdQueue[NRF24_CMD_QUEUE_SIZE];
+static volatile uint32_t nrf24_cmdReserve = 0;
+static volatile uint32_t nrf24_cmdTail = 0;
+#endif
+
+
+/* --- Link quality --- */
+// Updated by nrf24_irqHandler only
+static nrf24_link_stats_t nrf24_linkStats;
+static volatile uint8_t nrf24_linkAdapt = NRF24_LINK_ADAPT_OFF;
+static uint8_t nrf24_linkAdaptCount = 0;
+
+
+/* --- Fault log --- */
+// With NRF24_FAULT_LOG_NOINIT the log is placed in .noinit and the previous run's survives a reset,
+// otherwise it lives in .bss and starts empty. The magic word tells a valid log from power-on garbage.
+#define NRF24_FAULT_LOG_MAGIC	0x4E524654u
+
+#ifdef NRF24_FAULT_LOG_NOINIT
+#define NRF24_FAULT_LOG_SECTION	__attribute__((section(".noinit")))
+#else
+#define NRF24_FAULT_LOG_SECTION
+#endif
+
+typedef struct {
+	uint32_t magic;
+	volatile uint32_t count[NRF24_FAULT_COUNT];
+	volatile uint32_t head;		// # of faults logged so far, the newest is entry[(head - 1) % NRF24_FAULT_LOG_SIZE]
+	nrf24_fault_t entry[NRF24_FAULT_LOG_SIZE];
+} nrf24_fault_log_t;
+
+_Static_assert( (NRF24_FAULT_LOG_SIZE & (NRF24_FAULT_LOG_SIZE - 1)) == 0, "NRF24_FAULT_LOG_SIZE must be a power of two" );
+
+static nrf24_fault_log_t nrf24_faultLog NRF24_FAULT_LOG_SECTION;
+
+
+#ifdef NRF24_USE_PROFILING
+/* --- Profiling --- */
+static nrf24_profile_t nrf24_profile[NRF24_PROFILE_COUNT];
+
+static const char* const nrf24_profileName[NRF24_PROFILE_COUNT] = {
+	"writeReg",
+	"readReg",
+	"sendStandaloneCmd",
+	"irqHandler",
+	"spiFrame",
+};
+#endif
+
+
+/* --- Shadow registers --- */
+// Last value written to / read from each cacheable register, indexed by register address.
+// Multi-byte address registers are kept in nrf24_shadowAddr instead.
+static uint8_t nrf24_shadow[NRF24_SHADOW_REG_COUNT];
+static uint8_t nrf24_shadowAddr[NRF24_SHADOW_ADDR_COUNT][NRF24_ADDR_MAX_WIDTH];
+static uint8_t nrf24_shadowAddrLen[NRF24_SHADOW_ADDR_COUNT];
+
+// Bit per register address: 1 = shadow holds the chip's value
+// (also updated from the DMA completion interrupt, see nrf24_shadowSetValid)
+static volatile uint32_t nrf24_shadowValid = 0;
+
+static nrf24_shadow_stats_t nrf24_shadowStats;
+
+/*
+ * nrf24_atomicIncrement - Lock-free increment (LDREX/STREX), safe against ISRs preempting it
+ *
+ * *uint32_t @word: counter to increment
+ * 
+ * @return: incremented value
+ */
+__STATIC_FORCEINLINE uint32_t nrf24_atomicIncrement( volatile uint32_t* word ){
+	uint32_t value;
+
+	do {
+		value = __LDREXW( word ) + 1u;
+	} while( __STREXW(value, word) );
+
+	return value;
+}
+
+/*
+ * nrf24_faultLogCheck - Clears the fault log if it does not hold a valid one (first power-on)
+ *
+ * @return: void
+ */
+static void nrf24_faultLogCheck( void ){
+	if( nrf24_faultLog.magic != NRF24_FAULT_LOG_MAGIC ){
+		memset( &nrf24_faultLog, 0, sizeof(nrf24_faultLog) );
+		nrf24_faultLog.magic = NRF24_FAULT_LOG_MAGIC;
+	}
+}
+
+/*
+ * centralized_errorHandler - Records a fault raised by NRF24_ERROR/NRF24_ASSERT: bumps the counter 
+ * of its code and logs it in the fault ring. Never blocks, the caller carries on with its error path.
+ * Callable from any context.
+ *
+ * uint32_t @id: NRF24_FAULT_ID(code, line)
+ * 
+ * @return: void 
+ */
+static void centralized_errorHandler( uint32_t id ){
+	uint8_t code = NRF24_FAULT_ID_CODE( id );
+	uint32_t slot;
+
+	nrf24_faultLogCheck();
+
+	if( code < NRF24_FAULT_COUNT ){
+		nrf24_atomicIncrement( &nrf24_faultLog.count[code] );
+	}
+
+	// Each fault owns its slot, an ISR preempting this one takes the next
+	slot = (nrf24_atomicIncrement( &nrf24_faultLog.head ) - 1u) & (NRF24_FAULT_LOG_SIZE - 1u);
+	nrf24_faultLog.entry[slot].id = id;
+	nrf24_faultLog.entry[slot].tick = HAL_GetTick();
+}
+
+
+/*
+* Chip enable, disable functions.
+* 1 = Chip is enabled
+* 0 = Chip is disabled
+* A single store to BSRR: atomic, no read-modify-write and no call into HAL_GPIO_WritePin
+*/
+__STATIC_FORCEINLINE void CE_Enable( void ){
+	NRF24_CE_PORT->BSRR = NRF24_CE_BSRR_SET;
+}
+
+__STATIC_FORCEINLINE void CE_Disable( void ){
+	NRF24_CE_PORT->BSRR = NRF24_CE_BSRR_RESET;
+}
+
+__STATIC_FORCEINLINE uint8_t CE_IsEnabled( void ){
+	return (NRF24_CE_PORT->ODR & NRF24_CE_PIN) ? TRUE : FALSE;
+}
+
+/*
+* Time base: the DWT cycle counter, enabled by nrf24_Init.
+* Free-running at SystemCoreClock, differences are wrap-safe with unsigned arithmetic.
+*/
+static void nrf24_timeInit( void ){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+__STATIC_FORCEINLINE uint32_t nrf24_cycles( void ){
+	return DWT->CYCCNT;
+}
+
+__STATIC_FORCEINLINE uint32_t nrf24_usToCycles( uint32_t us ){
+	return us * (SystemCoreClock / 1000000u);
+}
+
+static void nrf24_delayUs( uint32_t us ){
+	uint32_t start = nrf24_cycles();
+	uint32_t cycles = nrf24_usToCycles( us );
+
+	while( (nrf24_cycles() - start) < cycles );
+}
+
+#ifdef NRF24_USE_PROFILING
+/*
+ * nrf24_profileRecord - Adds one run of a profiled region to its statistics
+ * IRQs are masked for the few updates so a region profiled from both thread and IRQ context stays consistent.
+ *
+ * uint8_t @region:		@NRF24_PROFILE_xx
+ * uint32_t @cycles:	duration of the run
+ * 
+ * @return: void
+ */
+static void nrf24_profileRecord( uint8_t region, uint32_t cycles ){
+	nrf24_profile_t* profile = &nrf24_profile[region];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if( profile->count == 0 || cycles < profile->min ){
+		profile->min = cycles;
+	}
+	if( cycles > profile->max ){
+		profile->max = cycles;
+	}
+	profile->count++;
+	profile->total += cycles;
+
+	// floor(log2(cycles)) in a single CLZ
+	profile->histogram[31u - __CLZ( cycles | 0b1u )]++;
+
+	__set_PRIMASK( primask );
+}
+#endif
+
+/*
+* SPI timeouts, derived from the frame length and the SPI clock instead of a fixed 1000ms.
+* A frame gets twice its wire time plus NRF24_SPI_TIMEOUT_MARGIN_US for interrupts and HAL overhead.
+*/
+static void nrf24_timeoutInit( void ){
+	uint32_t divider = 2u << ((NRF24_SPI_HANDLER.Init.BaudRatePrescaler & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos);
+	uint32_t spi_clock = NRF24_SPI_PCLK_FREQ() / divider;
+
+	nrf24_spiByteCycles = (8u * SystemCoreClock + spi_clock - 1u) / spi_clock;
+}
+
+__STATIC_FORCEINLINE uint32_t nrf24_frameTimeoutCycles( uint8_t length ){
+	return 2u * length * nrf24_spiByteCycles + nrf24_usToCycles( NRF24_SPI_TIMEOUT_MARGIN_US );
+}
+
+// SysTick has to preempt the IRQ handler, HAL_GetTick would stand still inside it otherwise
+_Static_assert( NRF24_IRQ_NVIC_PRIORITY > TICK_INT_PRIORITY, "NRF24_IRQ_NVIC_PRIORITY must be below the SysTick priority" );
+
+// HAL counts in 1ms ticks: one extra tick so a timeout armed just before a tick edge is not cut short
+__STATIC_FORCEINLINE uint32_t nrf24_frameTimeoutMs( uint8_t length ){
+	return nrf24_frameTimeoutCycles( length ) / (SystemCoreClock / 1000u) + 2u;
+}
+
+/*
+* Slave select, deselect functions.
+* 0 = Slave is selected
+* 1 = Slave is deselected
+*/
+__STATIC_FORCEINLINE void NSS_Select( void ){
+	NRF24_NSS_PORT->BSRR = NRF24_NSS_BSRR_RESET;
+}
+
+__STATIC_FORCEINLINE void NSS_Deselect( void ){
+	NRF24_NSS_PORT->BSRR = NRF24_NSS_BSRR_SET;
+}
+
+
+
+/* --- Transport --- */
+/*
+ * nrf24_prepareFrame - Fills the TX frame with the @cmd byte followed by @size bytes of @data
+ *
+ * uint8_t @cmd:			The command byte (instruction mnemonic)
+ * *uint8_t @data:		Bytes to be sent after the command (NULL = send NOPs to clock the reply out)
+ * uint8_t @size:			# of bytes after the command byte
+ * 
+ * @return: NRF24_OK, NRF24_ERR_PARAM if @size does not fit a frame (nothing copied)
+ */
+static inline nrf24_err_t nrf24_prepareFrame( uint8_t cmd, uint8_t* data, uint8_t size ){
+	NRF24_ASSERT_RETURN( size <= NRF24_MAX_PAYLOAD_SIZE, NRF24_ERR_PARAM );
+
+	nrf24_txFrame[0] = cmd;
+	if( data != NULL ){
+		memcpy( &nrf24_txFrame[1], data, size );
+	} else {
+		memset( &nrf24_txFrame[1], NOP, size );
+	}
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_busTryAcquire - Takes ownership of the SPI bus without waiting (LDREX/STREX, no IRQ masking)
+ *
+ * @return: TRUE if the bus is now owned by the caller, FALSE if someone else owns it
+ */
+static inline uint8_t nrf24_busTryAcquire( void ){
+	do {
+		if( __LDREXB(&nrf24_spiBusy) ){
+			__CLREX();
+			return FALSE;
+		}
+	} while( __STREXB(TRUE, &nrf24_spiBusy) );
+
+	__DMB();
+	return TRUE;
+}
+
+/*
+ * nrf24_busAcquire - Waits for and takes ownership of the SPI bus
+ * [WARNING] - thread context only. An ISR owns the bus only while it runs, but a DMA frame 
+ * started by an ISR keeps it until its completion interrupt.
+ * The wait is bounded by the longest run of queued DMA frames; past that the frame in flight
+ * is considered stuck and aborted.
+ *
+ * @return: NRF24_OK if the bus is now owned by the caller, NRF24_ERR_BUSY on timeout
+ */
+static inline nrf24_err_t nrf24_busAcquire( void ){
+	uint32_t start = nrf24_cycles();
+	uint32_t limit = nrf24_frameTimeoutCycles( NRF24_MAX_FRAME_SIZE ) * (NRF24_CMD_QUEUE_SIZE + 1u);
+
+	while( !nrf24_busTryAcquire() ){
+		if( (nrf24_cycles() - start) > limit ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+			nrf24_abortStuckFrame();
+#endif
+			NRF24_ERROR( NRF24_FAULT_BUS_BUSY );
+			return NRF24_ERR_BUSY;
+		}
+	}
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_busRelease - Gives up the SPI bus and re-triggers an IRQ that was deferred while it was owned
+ * The EXTI software trigger sets the pending bit, so the regular EXTI handler path runs.
+ *
+ * @return: void
+ */
+static inline void nrf24_busRelease( void ){
+	__DMB();
+	nrf24_spiBusy = FALSE;
+
+	if( nrf24_irqPending ){
+		nrf24_irqPending = FALSE;
+		__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+	}
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	// The radio IRQ goes first, its own release resumes the command queue
+	else {
+		// Pairs with the DMB in nrf24_submitCmd: either the submitter got the bus or the queue is seen
+		__DMB();
+		nrf24_cmdQueuePump();
+	}
+#endif
+}
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+/*
+ * nrf24_startFrame - Clocks out the @cmd byte followed by @size bytes in a single DMA transfer
+ *
+ * uint8_t @cmd:									The command byte (instruction mnemonic)
+ * *uint8_t @data:								Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:							Where to store the @size bytes received after the STATUS byte (NULL = discard)
+ * uint8_t @size:									# of bytes after the command byte
+ * nrf24_callback_t @callback:		Invoked from the DMA interrupt once NSS is released (NULL = none)
+ * 
+ * @return: NRF24_OK if the frame was started, error code otherwise
+ */
+static nrf24_err_t nrf24_startFrame( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback ){
+	// Only one frame can be on the bus at a time
+	if( nrf24_busAcquire() != NRF24_OK ){
+		return NRF24_ERR_BUSY;
+	}
+
+	return nrf24_startFrameLocked( cmd, data, buffer, size, callback );
+}
+
+/*
+ * nrf24_startFrameLocked - Same as nrf24_startFrame on a bus the caller already owns,
+ * ownership passes to the frame and ends in its completion interrupt
+ *
+ * uint8_t @cmd:									The command byte (instruction mnemonic)
+ * *uint8_t @data:								Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:							Where to store the @size bytes received after the STATUS byte (NULL = discard)
+ * uint8_t @size:									# of bytes after the command byte
+ * nrf24_callback_t @callback:		Invoked from the DMA interrupt once NSS is released (NULL = none)
+ * 
+ * @return: NRF24_OK if the frame was started, NRF24_ERR_PARAM if @size does not fit a frame,
+ * NRF24_ERR_SPI otherwise (bus released)
+ */
+static nrf24_err_t nrf24_startFrameLocked( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback ){
+	nrf24_err_t err = nrf24_dmaFrameLocked( cmd, data, buffer, size, callback );
+
+	if( err != NRF24_OK ){
+		nrf24_busRelease();
+	}
+
+	return err;
+}
+
+/*
+ * nrf24_dmaFrameLocked - Starts the DMA transfer of one frame on a bus the caller owns
+ * and keeps the bus owned if it fails
+ *
+ * uint8_t @cmd:									The command byte (instruction mnemonic)
+ * *uint8_t @data:								Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:							Where to store the @size bytes received after the STATUS byte (NULL = discard)
+ * uint8_t @size:									# of bytes after the command byte
+ * nrf24_callback_t @callback:		Invoked from the DMA interrupt once NSS is released (NULL = none)
+ * 
+ * @return: NRF24_OK if the frame was started, NRF24_ERR_PARAM if @size does not fit a frame,
+ * NRF24_ERR_SPI otherwise
+ */
+static nrf24_err_t nrf24_dmaFrameLocked( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback ){
+	if( nrf24_prepareFrame( cmd, data, size ) != NRF24_OK ){
+		return NRF24_ERR_PARAM;
+	}
+
+	nrf24_pendingBuffer = buffer;
+	nrf24_pendingSize = size;
+	nrf24_pendingCallback = callback;
+
+	nrf24_frameStart = nrf24_cycles();
+	nrf24_frameLength = size + 1;
+
+	// Enable listening on the NRF24's end by pulling NSS pin low (SPI logic)
+	NSS_Select();
+
+	// The rest is handled by HAL_SPI_TxRxCpltCallback
+	if( HAL_SPI_TransmitReceive_DMA( &NRF24_SPI_HANDLER, nrf24_txFrame, nrf24_rxFrame, size + 1 ) != HAL_OK ){
+		NSS_Deselect();
+		nrf24_shadowFrameDone( nrf24_txFrame, size + 1, FALSE );
+		NRF24_ERROR( NRF24_FAULT_DMA_START );
+		return NRF24_ERR_SPI;
+	}
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_abortStuckFrame - Aborts the DMA frame in flight if it is past its deadline and frees the bus
+ * Its completion callback is invoked with NRF24_ERR_TIMEOUT. An IRQ sequence waiting for
+ * the frame is resumed by the IRQ handler, re-triggered on the release.
+ *
+ * @return: void
+ */
+static void nrf24_abortStuckFrame( void ){
+	nrf24_callback_t callback;
+
+	if( !nrf24_spiBusy || (nrf24_cycles() - nrf24_frameStart) <= nrf24_frameTimeoutCycles( nrf24_frameLength ) ){
+		return;
+	}
+
+	HAL_SPI_Abort( &NRF24_SPI_HANDLER );
+	NSS_Deselect();
+	nrf24_shadowFrameDone( nrf24_txFrame, nrf24_frameLength, FALSE );
+	NRF24_ERROR( NRF24_FAULT_DMA_STUCK );
+
+	if( nrf24_pendingIrq ){
+		nrf24_pendingIrq = FALSE;
+		nrf24_irqPending = TRUE;
+		nrf24_busRelease();
+		return;
+	}
+
+	callback = nrf24_pendingCallback;
+	nrf24_busRelease();
+
+	if( callback != NULL ){
+		callback( NRF24_ERR_TIMEOUT, 0 );
+	}
+}
+
+/*
+ * HAL_SPI_TxRxCpltCallback - Overrides the weak HAL callback. Releases NRF24, copies the received 
+ * bytes and hands the STATUS byte to the caller of the finished frame, or resumes the IRQ sequence
+ * that started it.
+ *
+ * SPI_HandleTypeDef* @hspi: SPI handler that finished the transfer
+ * 
+ * @return: void
+ */
+void HAL_SPI_TxRxCpltCallback( SPI_HandleTypeDef* hspi ){
+	nrf24_callback_t callback;
+	uint8_t status;
+
+	if( hspi != &NRF24_SPI_HANDLER ){
+		return;
+	}
+
+	// Release NRF24
+	NSS_Deselect();
+#ifdef NRF24_USE_PROFILING
+	nrf24_profileRecord( NRF24_PROFILE_SPI_FRAME, nrf24_cycles() - nrf24_frameStart );
+#endif
+
+	// Skip the STATUS byte clocked out together with the command
+	if( nrf24_pendingBuffer != NULL ){
+		memcpy( nrf24_pendingBuffer, &nrf24_rxFrame[1], nrf24_pendingSize );
+	}
+
+	// Register writes are known to be in the chip now
+	nrf24_shadowFrameDone( nrf24_txFrame, nrf24_frameLength, TRUE );
+
+	status = nrf24_rxFrame[0];
+	nrf24_lastStatus = status;
+
+	// Payload frame of the IRQ sequence: the bus stays owned and the sequence goes on
+	if( nrf24_pendingIrq ){
+		nrf24_pendingIrq = FALSE;
+		nrf24_irqRun( NRF24_OK );
+		return;
+	}
+
+	// Free the bus before the callback so it can chain another frame
+	callback = nrf24_pendingCallback;
+	nrf24_busRelease();
+
+	if( callback != NULL ){
+		callback( NRF24_OK, status );
+	}
+}
+
+/*
+ * HAL_SPI_ErrorCallback - Overrides the weak HAL callback. Releases NRF24 and the bus on a DMA/SPI error
+ * and reports NRF24_ERR_SPI to the caller of the failed frame (or to the IRQ sequence that waited for it).
+ *
+ * SPI_HandleTypeDef* @hspi: SPI handler that failed
+ * 
+ * @return: void
+ */
+void HAL_SPI_ErrorCallback( SPI_HandleTypeDef* hspi ){
+	nrf24_callback_t callback;
+
+	if( hspi != &NRF24_SPI_HANDLER ){
+		return;
+	}
+
+	NSS_Deselect();
+	nrf24_shadowFrameDone( nrf24_txFrame, nrf24_frameLength, FALSE );
+	NRF24_ERROR( NRF24_FAULT_DMA_ERROR );
+
+	if( nrf24_pendingIrq ){
+		nrf24_pendingIrq = FALSE;
+		nrf24_irqRun( NRF24_ERR_SPI );
+		return;
+	}
+
+	callback = nrf24_pendingCallback;
+	nrf24_busRelease();
+
+	if( callback != NULL ){
+		callback( NRF24_ERR_SPI, 0 );
+	}
+}
+#endif
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_REGISTER
+/*
+ * nrf24_spiWaitFlag - Waits for the @flag of the SPI status register until the @deadline
+ *
+ * SPI_TypeDef* @spi:		SPI peripheral
+ * uint32_t @flag:			SPI_SR_xx flag to be waited for
+ * uint32_t @start:			DWT cycle count at the start of the frame
+ * uint32_t @deadline:	# of cycles the whole frame may take
+ * 
+ * @return: NRF24_OK once the flag is set, NRF24_ERR_TIMEOUT past the deadline
+ */
+__STATIC_FORCEINLINE nrf24_err_t nrf24_spiWaitFlag( SPI_TypeDef* spi, uint32_t flag, uint32_t start, uint32_t deadline ){
+	while( (spi->SR & flag) == 0 ){
+		if( (nrf24_cycles() - start) > deadline ){
+			return NRF24_ERR_TIMEOUT;
+		}
+	}
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_spiExchange - Full-duplex exchange of @size bytes straight on the SPI registers
+ * The next byte is written as soon as TXE is set, while the previous one is still shifting,
+ * so the bus has no idle gaps between bytes. At most 2 bytes are in flight, RX is drained
+ * right after each write to stay ahead of an overrun.
+ * Every flag wait is bounded by the frame's deadline (DWT cycles).
+ *
+ * *uint8_t @tx:		Bytes to be sent
+ * *uint8_t @rx:		Where to store the received bytes
+ * uint8_t @size:		# of bytes to exchange (>= 1)
+ * 
+ * @return: NRF24_OK, NRF24_ERR_TIMEOUT if a flag never came, NRF24_ERR_SPI on an overrun
+ */
+static inline nrf24_err_t nrf24_spiExchange( uint8_t* tx, uint8_t* rx, uint8_t size ){
+	SPI_TypeDef* spi = NRF24_SPI_HANDLER.Instance;
+	uint32_t start = nrf24_cycles();
+	uint32_t deadline = nrf24_frameTimeoutCycles( size );
+	uint8_t i;
+
+	// HAL only sets SPE on its first transfer
+	if( (spi->CR1 & SPI_CR1_SPE) == 0 ){
+		spi->CR1 |= SPI_CR1_SPE;
+	}
+
+	// Prime the shift register
+	*(__IO uint8_t*)&spi->DR = tx[0];
+
+	for( i = 1; i < size; i++ ){
+		// Queue the next byte behind the one being shifted out
+		if( nrf24_spiWaitFlag( spi, SPI_SR_TXE, start, deadline ) != NRF24_OK ){
+			return NRF24_ERR_TIMEOUT;
+		}
+		*(__IO uint8_t*)&spi->DR = tx[i];
+
+		// Collect the previous byte
+		if( nrf24_spiWaitFlag( spi, SPI_SR_RXNE, start, deadline ) != NRF24_OK ){
+			return NRF24_ERR_TIMEOUT;
+		}
+		rx[i - 1] = *(__IO uint8_t*)&spi->DR;
+	}
+
+	// Collect the last byte, RXNE also means the shifter is done
+	if( nrf24_spiWaitFlag( spi, SPI_SR_RXNE, start, deadline ) != NRF24_OK ){
+		return NRF24_ERR_TIMEOUT;
+	}
+	rx[size - 1] = *(__IO uint8_t*)&spi->DR;
+
+	// An interrupt longer than one byte time between the write and the read above loses a byte.
+	// Reading DR then SR clears OVR
+	if( spi->SR & SPI_SR_OVR ){
+		(void)*(__IO uint8_t*)&spi->DR;
+		(void)spi->SR;
+		return NRF24_ERR_SPI;
+	}
+
+	return NRF24_OK;
+}
+#endif
+
+/*
+ * nrf24_frameLocked - Clocks a prepared frame (command byte first) out on a bus the caller owns,
+ * the reply lands in nrf24_rxFrame. Failures are reported to centralized_errorHandler.
+ * The HAL timeout runs on SysTick, also from the IRQ handler (see NRF24_IRQ_NVIC_PRIORITY).
+ *
+ * *uint8_t @frame:	Command byte followed by its data bytes
+ * uint8_t @length:	# of frame bytes (command included)
+ * 
+ * @return: NRF24_OK, NRF24_ERR_TIMEOUT or NRF24_ERR_SPI
+ */
+static inline nrf24_err_t nrf24_frameLocked( uint8_t* frame, uint8_t length ){
+	nrf24_err_t err;
+	NRF24_PROFILE_BEGIN();
+
+	// Enable listening on the NRF24's end by pulling NSS pin low (SPI logic)
+	NSS_Select();
+
+	// Command and data out, STATUS and reply in
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_REGISTER
+	err = nrf24_spiExchange( frame, nrf24_rxFrame, length );
+#else
+	switch( HAL_SPI_TransmitReceive( &NRF24_SPI_HANDLER, frame, nrf24_rxFrame, length, nrf24_frameTimeoutMs(length) ) ){
+		case HAL_OK:			err = NRF24_OK;					break;
+		case HAL_TIMEOUT:	err = NRF24_ERR_TIMEOUT;	break;
+		default:					err = NRF24_ERR_SPI;			break;
+	}
+#endif
+
+	// Release NRF24
+	NSS_Deselect();
+	NRF24_PROFILE_END( NRF24_PROFILE_SPI_FRAME );
+
+	if( err == NRF24_ERR_TIMEOUT ){
+		NRF24_ERROR( NRF24_FAULT_SPI_TIMEOUT );
+	} else if( err != NRF24_OK ){
+		NRF24_ERROR( NRF24_FAULT_SPI );
+	} else {
+		nrf24_lastStatus = nrf24_rxFrame[0];
+	}
+
+	return err;
+}
+
+/*
+ * nrf24_transferLocked - Executes one command as a single full-duplex SPI frame on a bus the caller owns
+ * The first byte clocked out by NRF24 is always STATUS, so it is captured for free.
+ * Blocking with every transport: the DMA transport only serves the asynchronous APIs, 
+ * so this is safe to use from interrupt context.
+ *
+ * uint8_t @cmd:			The command byte (instruction mnemonic)
+ * *uint8_t @data:		Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:	Where to store the @size bytes received after STATUS (NULL = discard)
+ * uint8_t @size:			# of bytes after the command byte
+ * 
+ * @return: NRF24_OK (STATUS in nrf24_lastStatus), error code otherwise
+ */
+static nrf24_err_t nrf24_transferLocked( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size ){
+	nrf24_err_t err;
+
+	err = nrf24_prepareFrame( cmd, data, size );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	err = nrf24_frameLocked( nrf24_txFrame, size + 1 );
+
+	// Skip the STATUS byte clocked out together with the command
+	if( err == NRF24_OK && buffer != NULL ){
+		memcpy( buffer, &nrf24_rxFrame[1], size );
+	}
+
+	return err;
+}
+
+/*
+ * nrf24_transfer - Executes one command as a single full-duplex SPI frame and waits for it to finish
+ *
+ * uint8_t @cmd:			The command byte (instruction mnemonic)
+ * *uint8_t @data:		Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:	Where to store the @size bytes received after STATUS (NULL = discard)
+ * uint8_t @size:			# of bytes after the command byte
+ * 
+ * @return: NRF24_OK (STATUS in nrf24_lastStatus), error code otherwise
+ */
+static nrf24_err_t nrf24_transfer( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size ){
+	nrf24_err_t err;
+
+	if( nrf24_busAcquire() != NRF24_OK ){
+		return NRF24_ERR_BUSY;
+	}
+
+	err = nrf24_transferLocked( cmd, data, buffer, size );
+	nrf24_busRelease();
+
+	return err;
+}
+
+
+
+/* --- General APIs --- */
+
+/*
+ * nrf24_writeReg - Writes @size # of data bytes to the @reg NRF24 register
+ *
+ * uint8_t @reg:		The 5bit register address: 000AAAAA
+ * *uint8_t @data:	Data to be written to the register
+ * uint8_t @size:		# of data bytes to be transmitted (size of the TX buffer)
+ * 
+ * @return: NRF24_OK (STATUS via nrf24_getLastStatus), error code otherwise
+ */
+nrf24_err_t nrf24_writeReg( uint8_t reg, uint8_t* data, uint8_t size ){
+	nrf24_err_t err;
+	NRF24_PROFILE_BEGIN();
+
+	// Register. Write operation requires "001A AAAA" pattern
+	// where "A"s are the 5 bit register address
+	err = nrf24_transfer( W_REGISTER | (reg & REGISTER_MASK), data, NULL, size );
+
+	// Keep the shadow copy coherent with the chip: after a failed frame its value is unknown
+	if( err == NRF24_OK ){
+		nrf24_shadowStore( reg, data, size );
+	} else {
+		nrf24_shadowForget( reg );
+	}
+
+	NRF24_PROFILE_END( NRF24_PROFILE_WRITE_REG );
+	return err;
+}
+
+/*
+ * nrf24_readReg - Reads @size # of data bytes from the @reg NRF24 register
+ *
+ * uint8_t @reg:		The 5bit register address: 000AAAAA
+ * *uint8_t @data:	Data to be written to the register
+ * uint8_t @size:		# of data bytes to be received (size of the RX buffer)
+ * 
+ * @return: NRF24_OK (STATUS via nrf24_getLastStatus), error code otherwise
+ */
+nrf24_err_t nrf24_readReg( uint8_t reg, uint8_t* buffer, uint8_t size ){
+	nrf24_err_t err;
+	NRF24_PROFILE_BEGIN();
+
+	err = nrf24_transfer( R_REGISTER | (reg & REGISTER_MASK), NULL, buffer, size );
+
+	// Whatever the chip reported is the freshest value
+	if( err == NRF24_OK ){
+		nrf24_shadowStore( reg, buffer, size );
+	}
+
+	NRF24_PROFILE_END( NRF24_PROFILE_READ_REG );
+	return err;
+}
+
+/*
+ * nrf24_sendStandaloneCmd - Sends the @cmd command to the NRF24 module
+ *
+ * uint8_t @cmd: The standalone command(no data bytes) to be sent
+ * 
+ * @return: NRF24_OK (STATUS via nrf24_getLastStatus), error code otherwise
+ */
+nrf24_err_t nrf24_sendStandaloneCmd( uint8_t cmd ){
+	nrf24_err_t err;
+	NRF24_PROFILE_BEGIN();
+
+	err = nrf24_transfer( cmd, NULL, NULL, 0 );
+
+	NRF24_PROFILE_END( NRF24_PROFILE_STANDALONE_CMD );
+	return err;
+}
+
+/*
+ * nrf24_getStatus - Reads the STATUS register with a single NOP byte
+ * (instead of the 2-byte R_REGISTER access to NRF24_REG_STATUS)
+ *
+ * *uint8_t @status: Where the STATUS register value is stored
+ * 
+ * @return: NRF24_OK, error code otherwise (@status untouched)
+ */
+nrf24_err_t nrf24_getStatus( uint8_t* status ){
+	nrf24_err_t err = nrf24_transfer( NOP, NULL, NULL, 0 );
+
+	if( err == NRF24_OK ){
+		*status = nrf24_lastStatus;
+	}
+
+	return err;
+}
+
+/*
+ * nrf24_getLastStatus - STATUS clocked out at the start of the last completed frame, no bus access
+ *
+ * @return: STATUS register value
+ */
+uint8_t nrf24_getLastStatus( void ){
+	return nrf24_lastStatus;
+}
+
+/*
+ * nrf24_writeRegAsync - Starts writing @size # of data bytes to the @reg NRF24 register and returns
+ * With the DMA transport @data is copied, so the caller's buffer can be reused right away.
+ * With the blocking transports the write is done in place and @callback is invoked before returning.
+ *
+ * uint8_t @reg:									The 5bit register address: 000AAAAA
+ * *uint8_t @data:								Data to be written to the register
+ * uint8_t @size:									# of data bytes to be transmitted (size of the TX buffer)
+ * nrf24_callback_t @callback:		Invoked with STATUS once the write is done, or with the DMA error (NULL = none)
+ * 
+ * @return: NRF24_OK if started (or done), error code otherwise (@callback is not invoked)
+ */
+nrf24_err_t nrf24_writeRegAsync( uint8_t reg, uint8_t* data, uint8_t size, nrf24_callback_t callback ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	// Unknown until the frame completes, HAL_SPI_TxRxCpltCallback records the value
+	nrf24_shadowForget( reg );
+	return nrf24_startFrame( W_REGISTER | (reg & REGISTER_MASK), data, NULL, size, callback );
+#else
+	nrf24_err_t err = nrf24_writeReg( reg, data, size );
+
+	if( err == NRF24_OK && callback != NULL ){
+		callback( NRF24_OK, nrf24_lastStatus );
+	}
+
+	return err;
+#endif
+}
+
+/*
+ * nrf24_readRegAsync - Starts reading @size # of data bytes from the @reg NRF24 register and returns
+ * @buffer must stay valid until @callback is invoked.
+ * With the blocking transports the read is done in place and @callback is invoked before returning.
+ *
+ * uint8_t @reg:									The 5bit register address: 000AAAAA
+ * *uint8_t @buffer:							Where the received bytes are stored
+ * uint8_t @size:									# of data bytes to be received (size of the RX buffer)
+ * nrf24_callback_t @callback:		Invoked with STATUS once @buffer is filled, or with the DMA error (NULL = none)
+ * 
+ * @return: NRF24_OK if started (or done), error code otherwise (@callback is not invoked)
+ */
+nrf24_err_t nrf24_readRegAsync( uint8_t reg, uint8_t* buffer, uint8_t size, nrf24_callback_t callback ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	return nrf24_startFrame( R_REGISTER | (reg & REGISTER_MASK), NULL, buffer, size, callback );
+#else
+	nrf24_err_t err = nrf24_readReg( reg, buffer, size );
+
+	if( err == NRF24_OK && callback != NULL ){
+		callback( NRF24_OK, nrf24_lastStatus );
+	}
+
+	return err;
+#endif
+}
+
+/*
+ * nrf24_isBusy - Checks if the SPI bus is owned (a frame or an asynchronous DMA frame is in progress)
+ *
+ * @return: TRUE if a frame is in progress, FALSE otherwise
+ */
+uint8_t nrf24_isBusy( void ){
+	return nrf24_spiBusy;
+}
+
+
+
+/* --- Command queue APIs --- */
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+/*
+ * nrf24_cmdQueuePump - Starts the oldest queued command if the bus is free
+ * Called on every bus release, so the queue drains one DMA frame per completion interrupt.
+ * If the bus is owned, its owner's release calls this again.
+ * A command that cannot start gets its callback invoked with the error (the release pumps the next one).
+ *
+ * @return: void
+ */
+static void nrf24_cmdQueuePump( void ){
+	nrf24_cmd_t* entry = &nrf24_cmdQueue[nrf24_cmdTail & (NRF24_CMD_QUEUE_SIZE - 1)];
+	nrf24_cmd_t cmd;
+	nrf24_err_t err;
+
+	if( !entry->ready || !nrf24_busTryAcquire() ){
+		return;
+	}
+
+	// Drained by another bus owner in between
+	entry = &nrf24_cmdQueue[nrf24_cmdTail & (NRF24_CMD_QUEUE_SIZE - 1)];
+	if( !entry->ready ){
+		nrf24_busRelease();
+		return;
+	}
+
+	// Take the command out and free the slot before the frame starts (its completion pumps again)
+	cmd = *entry;
+	entry->ready = FALSE;
+	__DMB();
+	nrf24_cmdTail = nrf24_cmdTail + 1;
+
+	err = nrf24_startFrameLocked( cmd.cmd, cmd.data, cmd.buffer, cmd.size, cmd.callback );
+	if( err != NRF24_OK && cmd.callback != NULL ){
+		cmd.callback( err, 0 );
+	}
+}
+#endif
+
+/*
+ * nrf24_submitCmd - Appends a command to the queue and returns without waiting for the bus
+ * Commands run in submission order, one DMA frame each, and the next one is started from the
+ * completion interrupt of the previous one. With the DMA transport it is safe to call from thread
+ * and interrupt context alike.
+ * @data is copied; @buffer must stay valid until @callback is invoked.
+ * Register writes update the shadow copy once their frame has completed.
+ * With the blocking transports the command is executed in place and @callback is invoked before returning.
+ * [WARNING] - blocking transports: thread context only. The call waits for the bus, so from an ISR that
+ * preempted the bus owner it spins until the bus timeout and fails with NRF24_ERR_BUSY.
+ *
+ * uint8_t @cmd:									The command byte (instruction mnemonic, e.g. W_TX_PAYLOAD, R_REGISTER | reg, FLUSH_RX)
+ * *uint8_t @data:								Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:							Where to store the @size bytes received after STATUS (NULL = discard)
+ * uint8_t @size:									# of bytes after the command byte
+ * nrf24_callback_t @callback:		Invoked with STATUS once the command is done, or with the error that ended it (NULL = none)
+ * 
+ * @return: NRF24_OK if queued (or executed), NRF24_ERR_PARAM if @size > 32, NRF24_ERR_FULL if the queue is full,
+ * NRF24_ERR_BUSY if the bus was not freed (blocking transports), transfer error otherwise
+ */
+nrf24_err_t nrf24_submitCmd( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size, nrf24_callback_t callback ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	nrf24_cmd_t* entry;
+	uint32_t reserve;
+
+	NRF24_ASSERT_RETURN( size <= NRF24_MAX_PAYLOAD_SIZE, NRF24_ERR_PARAM );
+
+	// Reserve a slot against other producers
+	do {
+		reserve = __LDREXW( &nrf24_cmdReserve );
+		if( reserve - nrf24_cmdTail >= NRF24_CMD_QUEUE_SIZE ){
+			__CLREX();
+			return NRF24_ERR_FULL;
+		}
+	} while( __STREXW(reserve + 1, &nrf24_cmdReserve) );
+
+	entry = &nrf24_cmdQueue[reserve & (NRF24_CMD_QUEUE_SIZE - 1)];
+	entry->cmd = cmd;
+	entry->size = size;
+	entry->buffer = buffer;
+	entry->callback = callback;
+	if( data != NULL ){
+		memcpy( entry->data, data, size );
+	} else {
+		memset( entry->data, NOP, size );
+	}
+
+	// Unknown until the frame completes, HAL_SPI_TxRxCpltCallback records the value
+	if( (cmd & ~REGISTER_MASK) == W_REGISTER ){
+		nrf24_shadowForget( cmd );
+	}
+
+	// Publish the slot, then try to start it (see nrf24_busRelease)
+	__DMB();
+	entry->ready = TRUE;
+	__DMB();
+	nrf24_cmdQueuePump();
+
+	return NRF24_OK;
+#else
+	nrf24_err_t err;
+
+	NRF24_ASSERT_RETURN( size <= NRF24_MAX_PAYLOAD_SIZE, NRF24_ERR_PARAM );
+
+	err = nrf24_transfer( cmd, data, buffer, size );
+
+	if( (cmd & ~REGISTER_MASK) == W_REGISTER ){
+		nrf24_shadowFrameDone( nrf24_txFrame, size + 1, err == NRF24_OK );
+	}
+
+	if( err == NRF24_OK && callback != NULL ){
+		callback( NRF24_OK, nrf24_lastStatus );
+	}
+
+	return err;
+#endif
+}
+
+/*
+ * nrf24_cmdPending - # of submitted commands not started yet
+ *
+ * @return: # of commands
+ */
+uint8_t nrf24_cmdPending( void ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	return (uint8_t)(nrf24_cmdReserve - nrf24_cmdTail);
+#else
+	return 0;
+#endif
+}
+
+
+/* --- Payload rings --- */
+
+/*
+ * nrf24_ringLevel - # of payloads waiting in the @ring
+ *
+ * nrf24_ring_t* @ring: ring to be checked
+ * 
+ * @return: # of filled slots
+ */
+static inline uint32_t nrf24_ringLevel( nrf24_ring_t* ring ){
+	return ring->head - ring->tail;
+}
+
+/*
+ * nrf24_ringReserve - [Producer] Returns the next free slot of the @ring without publishing it
+ *
+ * nrf24_ring_t* @ring: ring to be filled
+ * 
+ * @return: slot to be written, NULL if the ring is full
+ */
+static inline uint8_t* nrf24_ringReserve( nrf24_ring_t* ring ){
+	if( nrf24_ringLevel(ring) >= NRF24_RING_SIZE ){
+		return NULL;
+	}
+
+	return ring->data[ring->head & (NRF24_RING_SIZE - 1)];
+}
+
+/*
+ * nrf24_ringCommit - [Producer] Publishes the slot returned by nrf24_ringReserve
+ *
+ * nrf24_ring_t* @ring:	ring being filled
+ * uint8_t @size:				# of valid bytes in the slot
+ * uint8_t @pipe:				pipe (or per-slot tag) stored next to the payload
+ * 
+ * @return: void
+ */
+static inline void nrf24_ringCommit( nrf24_ring_t* ring, uint8_t size, uint8_t pipe ){
+	uint32_t index = ring->head & (NRF24_RING_SIZE - 1);
+	uint32_t level;
+
+	ring->size[index] = size;
+	ring->pipe[index] = pipe;
+
+	// Slot contents must be visible before the consumer sees the new head
+	__DMB();
+	ring->head = ring->head + 1;
+
+	level = nrf24_ringLevel(ring);
+	if( level > ring->high_watermark ){
+		ring->high_watermark = level;
+	}
+}
+
+/*
+ * nrf24_ringPeek - [Consumer] Returns the oldest filled slot of the @ring without releasing it
+ *
+ * nrf24_ring_t* @ring: ring to be drained
+ * 
+ * @return: slot index (to be masked), or -1 if the ring is empty
+ */
+static inline int32_t nrf24_ringPeek( nrf24_ring_t* ring ){
+	if( nrf24_ringLevel(ring) == 0 ){
+		return -1;
+	}
+
+	// Slot contents must not be read before head was observed
+	__DMB();
+	return (int32_t)(ring->tail & (NRF24_RING_SIZE - 1));
+}
+
+/*
+ * nrf24_ringRelease - [Consumer] Gives the slot returned by nrf24_ringPeek back to the producer
+ *
+ * nrf24_ring_t* @ring: ring being drained
+ * 
+ * @return: void
+ */
+static inline void nrf24_ringRelease( nrf24_ring_t* ring ){
+	// Slot contents must be consumed before the producer can reuse the slot
+	__DMB();
+	ring->tail = ring->tail + 1;
+}
+
+
+
+/* --- Batch APIs --- */
+
+/*
+ * nrf24_batchInit - Empties the @batch so a new sequence of commands can be built
+ *
+ * nrf24_batch_t* @batch: batch to be reset
+ * 
+ * @return: void
+ */
+void nrf24_batchInit( nrf24_batch_t* batch ){
+	batch->length = 0;
+	batch->count = 0;
+}
+
+/*
+ * nrf24_batchCmd - Appends the @cmd command with @size data bytes to the @batch
+ * The entry is stored as [size][cmd][data...], so cmd and data are already a ready frame.
+ *
+ * nrf24_batch_t* @batch:	batch being built
+ * uint8_t @cmd:					The command byte (instruction mnemonic)
+ * *uint8_t @data:				Bytes to be sent after the command (NULL = send NOPs)
+ * uint8_t @size:					# of bytes after the command byte
+ * 
+ * @return: NRF24_OK if appended, NRF24_ERR_PARAM if @size > 32, NRF24_ERR_FULL if the batch is full
+ */
+nrf24_err_t nrf24_batchCmd( nrf24_batch_t* batch, uint8_t cmd, uint8_t* data, uint8_t size ){
+	uint8_t* entry;
+
+	NRF24_ASSERT_RETURN( size <= NRF24_MAX_PAYLOAD_SIZE, NRF24_ERR_PARAM );
+
+	if( batch->length + size + 2 > NRF24_BATCH_SIZE ){
+		return NRF24_ERR_FULL;
+	}
+
+	entry = &batch->stream[batch->length];
+	entry[0] = size;
+	entry[1] = cmd;
+	if( data != NULL ){
+		memcpy( &entry[2], data, size );
+	} else {
+		memset( &entry[2], NOP, size );
+	}
+
+	batch->length += size + 2;
+	batch->count++;
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_batchWriteReg - Appends a write of @size bytes to the @reg register to the @batch
+ *
+ * nrf24_batch_t* @batch:	batch being built
+ * uint8_t @reg:					The 5bit register address: 000AAAAA
+ * *uint8_t @data:				Data to be written to the register
+ * uint8_t @size:					# of data bytes
+ * 
+ * @return: NRF24_OK if appended, NRF24_ERR_FULL if the batch is full
+ */
+nrf24_err_t nrf24_batchWriteReg( nrf24_batch_t* batch, uint8_t reg, uint8_t* data, uint8_t size ){
+	return nrf24_batchCmd( batch, W_REGISTER | (reg & REGISTER_MASK), data, size );
+}
+
+/*
+ * nrf24_batchWriteRegCached - Same as nrf24_batchWriteReg, but nothing is appended
+ * when the shadow copy shows that the chip already holds the value
+ *
+ * nrf24_batch_t* @batch:	batch being built
+ * uint8_t @reg:					The 5bit register address: 000AAAAA
+ * *uint8_t @data:				Data to be written to the register
+ * uint8_t @size:					# of data bytes
+ * 
+ * @return: NRF24_OK if appended or skipped, NRF24_ERR_FULL if the batch is full
+ */
+nrf24_err_t nrf24_batchWriteRegCached( nrf24_batch_t* batch, uint8_t reg, uint8_t* data, uint8_t size ){
+	reg &= REGISTER_MASK;
+
+	if( nrf24_shadowMatches(reg, data, size) ){
+		nrf24_shadowStats.hits++;
+		return NRF24_OK;
+	}
+
+	nrf24_shadowStats.misses++;
+	return nrf24_batchWriteReg( batch, reg, data, size );
+}
+
+/*
+ * nrf24_batchExecute - Runs every command of the @batch back-to-back under a single bus ownership
+ * Each command still gets its own NSS cycle (the chip executes a command on the NSS rising edge),
+ * but frames go straight out of the prepared stream: no per-command bus arbitration, frame copy
+ * or IRQ deferral in between. Completed register writes update the shadow copy, a failed one
+ * is forgotten. Replies are discarded.
+ *
+ * The batch stops at the first failed frame.
+ *
+ * nrf24_batch_t* @batch: batch to be executed (left intact, can be executed again)
+ * 
+ * @return: NRF24_OK (STATUS of the last command via nrf24_getLastStatus), error code otherwise
+ */
+nrf24_err_t nrf24_batchExecute( nrf24_batch_t* batch ){
+	uint8_t* entry;
+	uint8_t offset;
+	nrf24_err_t err = NRF24_OK;
+
+	if( batch->count == 0 ){
+		return NRF24_OK;
+	}
+
+	if( nrf24_busAcquire() != NRF24_OK ){
+		return NRF24_ERR_BUSY;
+	}
+
+	for( offset = 0; offset < batch->length; offset += entry[0] + 2 ){
+		entry = &batch->stream[offset];
+
+		err = nrf24_frameLocked( &entry[1], entry[0] + 1 );
+		nrf24_shadowFrameDone( &entry[1], entry[0] + 1, err == NRF24_OK );
+		if( err != NRF24_OK ){
+			break;
+		}
+	}
+
+	nrf24_busRelease();
+
+	return err;
+}
+
+
+
+/* --- Role APIs --- */
+
+/*
+ * nrf24_setRole - Turns the link around between PTX and PRX without re-initialization
+ * Only PRIM_RX is flipped in the cached CONFIG value, PWR_UP stays set, so the chip goes
+ * Standby-I -> RX/TX in the 130us settling time instead of a full nrf24_Init.
+ * Pipe #0 follows the role: RX_ADDR_P0 = TX_ADDR in PTX (auto-ACK reception), the pipe's own
+ * address in PRX. Address writes are skipped when the shadow copy already matches, so repeated
+ * turnarounds cost two frames (CONFIG + RX_ADDR_P0).
+ * Every other register keeps the value of @nrf24_config's nrf24_Init, which writes SETUP_RETR and
+ * RX_PW_P0 in both modes: for auto-ACK in PTX the pipe #0 must be enabled with auto_ack in the configuration.
+ * In PRX, CE is raised and the call returns once the receiver has settled.
+ * In PTX, the chip waits in Standby-I, nrf24_transmit raises CE.
+ *
+ * uint8_t @mode:										@NRF24_REG_CONFIG_PRIM_RX_Val
+ * nrf24_config_t* @nrf24_config:	configuration the chip was initialized with (addresses)
+ * 
+ * @return: NRF24_OK, NRF24_ERR_PARAM if the address width is out of range (nothing changed),
+ * error code otherwise (the chip is left in Standby-I)
+ */
+nrf24_err_t nrf24_setRole( uint8_t mode, nrf24_config_t* nrf24_config ){
+	uint8_t config;
+	uint8_t address_size = nrf24_config->address_width + 2;
+	nrf24_err_t err;
+
+	NRF24_ASSERT_RETURN( address_size >= 3 && address_size <= NRF24_ADDR_MAX_WIDTH, NRF24_ERR_PARAM );
+
+	/* Standby-I while the registers change, ends any TX streaming */
+	CE_Disable();
+	nrf24_txStreaming = FALSE;
+	nrf24_txDeferred = FALSE;
+
+	/* Pipe #0 addressing */
+	if( mode == NRF24_REG_CONFIG_PRIM_RX_Val_PTX ){
+		err = nrf24_writeRegCached( NRF24_REG_TX_ADDR, nrf24_config->tx_address, address_size );
+		if( err == NRF24_OK ){
+			err = nrf24_writeRegCached( NRF24_REG_RX_ADDR_P0, nrf24_config->tx_address, address_size );
+		}
+	} else {
+		err = nrf24_writeRegCached( NRF24_REG_RX_ADDR_P0, nrf24_config->pipes[0].address, address_size );
+	}
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	/* Flip PRIM_RX only */
+	err = nrf24_readRegCached( NRF24_REG_CONFIG, &config, 1 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+	config &= (uint8_t)~(0b1u << NRF24_REG_CONFIG_PRIM_RX_Pos);
+	config |= (uint8_t)(mode << NRF24_REG_CONFIG_PRIM_RX_Pos);
+	err = nrf24_writeRegCached( NRF24_REG_CONFIG, &config, 1 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	/* Receiver listens 130us after CE goes high */
+	if( mode == NRF24_REG_CONFIG_PRIM_RX_Val_PRX ){
+		err = nrf24_waitReady();
+		if( err != NRF24_OK ){
+			return err;
+		}
+		CE_Enable();
+		nrf24_delayUs( NRF24_RX_SETTLING_US );
+	}
+	// Payloads queued while in PRX are loaded now
+	else if( nrf24_ringLevel( &nrf24_txRing ) != 0 ){
+		__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+	}
+
+	return NRF24_OK;
+}
+
+
+
+/* --- Power APIs --- */
+
+/*
+ * nrf24_setPwrUp - Writes the PWR_UP bit through the cached CONFIG value
+ *
+ * uint8_t @pwr_up:		@NRF24_REG_CONFIG_PWR_UP_Val
+ * *uint8_t @changed:	Set to TRUE if the bit changed, FALSE if it already had the value
+ * 
+ * @return: NRF24_OK, error code otherwise
+ */
+static nrf24_err_t nrf24_setPwrUp( uint8_t pwr_up, uint8_t* changed ){
+	uint8_t config, updated;
+	nrf24_err_t err;
+
+	*changed = FALSE;
+
+	err = nrf24_readRegCached( NRF24_REG_CONFIG, &config, 1 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	updated = config & (uint8_t)~(0b1u << NRF24_REG_CONFIG_PWR_UP_Pos);
+	updated |= (uint8_t)(pwr_up << NRF24_REG_CONFIG_PWR_UP_Pos);
+
+	if( updated == config ){
+		return NRF24_OK;
+	}
+
+	err = nrf24_writeRegCached( NRF24_REG_CONFIG, &updated, 1 );
+	*changed = (err == NRF24_OK);
+	return err;
+}
+
+/*
+ * nrf24_powerUp - Power-down -> Standby-I, without waiting for the oscillator start-up
+ * The start of the transition is recorded: nrf24_waitReady only waits for whatever is left
+ * of the 1.5ms Tpd2stby, so the MCU can prepare the first payload meanwhile, and nrf24_transmit
+ * does not wait at all. Does nothing if the chip is already powered up.
+ *
+ * @return: NRF24_OK, error code otherwise
+ */
+nrf24_err_t nrf24_powerUp( void ){
+	uint8_t changed;
+	nrf24_err_t err = nrf24_setPwrUp( NRF24_REG_CONFIG_PWR_UP_Val_UP, &changed );
+
+	if( changed ){
+		nrf24_wakeCycles = nrf24_cycles();
+		nrf24_wakeTick = HAL_GetTick();
+		nrf24_waking = TRUE;
+	}
+
+	return err;
+}
+
+/*
+ * nrf24_powerDown - Any state -> Power-down (~900nA), register values are kept
+ * CE is dropped and TX streaming ends. Payloads still in the hardware TX FIFO stay there and
+ * are sent after the next nrf24_powerUp.
+ *
+ * @return: NRF24_OK, error code otherwise
+ */
+nrf24_err_t nrf24_powerDown( void ){
+	uint8_t changed;
+
+	CE_Disable();
+	nrf24_txStreaming = FALSE;
+	nrf24_txDeferred = FALSE;
+	nrf24_waking = FALSE;
+
+	return nrf24_setPwrUp( NRF24_REG_CONFIG_PWR_UP_Val_DOWN, &changed );
+}
+
+/*
+ * nrf24_standby - RX/TX/Standby-II -> Standby-I (~26uA, 130us back to RX/TX)
+ *
+ * @return: NRF24_OK (CE only, no bus access)
+ */
+nrf24_err_t nrf24_standby( void ){
+	CE_Disable();
+	nrf24_txStreaming = FALSE;
+	nrf24_txDeferred = FALSE;
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_isReady - Checks if the Tpd2stby start-up since the last nrf24_powerUp has elapsed
+ * The HAL tick covers long gaps in which the 32bit cycle counter could have wrapped.
+ *
+ * @return: TRUE if the chip can enter RX/TX, FALSE if it is still starting up (or powered down)
+ */
+uint8_t nrf24_isReady( void ){
+	if( nrf24_waking ){
+		if( (HAL_GetTick() - nrf24_wakeTick) <= (NRF24_POWER_UP_US / 1000u + 1u)
+		    && (nrf24_cycles() - nrf24_wakeCycles) < nrf24_usToCycles( NRF24_POWER_UP_US ) ){
+			return FALSE;
+		}
+		nrf24_waking = FALSE;
+	}
+
+	return (nrf24_shadow[NRF24_REG_CONFIG] >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u;
+}
+
+/*
+ * nrf24_waitReady - Waits only for the remaining part of the Tpd2stby start-up (none if already elapsed)
+ *
+ * @return: NRF24_OK once the chip is ready, NRF24_ERR_STATE if it is powered down
+ */
+nrf24_err_t nrf24_waitReady( void ){
+	if( ((nrf24_shadow[NRF24_REG_CONFIG] >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u) == 0 ){
+		return NRF24_ERR_STATE;
+	}
+
+	while( !nrf24_isReady() );
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_tick - SysTick hook (SysTick_Handler), re-triggers the IRQ handler while a TX start waits
+ * for the Tpd2stby start-up, so CE goes high at most one tick after it has elapsed, and after
+ * a failed STATUS frame, so flags left set on a low IRQ line (no new falling edge) are serviced.
+ *
+ * @return: void
+ */
+void nrf24_tick( void ){
+	if( nrf24_txDeferred || nrf24_irqRetry ){
+		__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+	}
+}
+
+/*
+ * nrf24_getPowerState - Current state of the chip's state machine
+ * Derived from the cached CONFIG value and the CE pin; telling Standby-II from TX needs
+ * one FIFO_STATUS read.
+ *
+ * *uint8_t @state: Where the @NRF24_POWER_STATE is stored
+ * 
+ * @return: NRF24_OK, error code otherwise (@state untouched)
+ */
+nrf24_err_t nrf24_getPowerState( uint8_t* state ){
+	uint8_t config = nrf24_shadow[NRF24_REG_CONFIG];
+	uint8_t fifo_status;
+	nrf24_err_t err;
+
+	if( ((config >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u) == 0 ){
+		*state = NRF24_POWER_STATE_POWER_DOWN;
+	} else if( !CE_IsEnabled() || !nrf24_isReady() ){
+		*state = NRF24_POWER_STATE_STANDBY_I;
+	} else if( (config >> NRF24_REG_CONFIG_PRIM_RX_Pos) & 0b1u ){
+		*state = NRF24_POWER_STATE_RX;
+	} else {
+		// PTX with CE high: transmitting while the TX FIFO has payloads, Standby-II otherwise
+		err = nrf24_readReg( NRF24_REG_FIFO_STATUS, &fifo_status, 1 );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		*state = ((fifo_status >> NRF24_REG_FIFO_STATUS_TX_EMPTY_Pos) & 0b1u) ? NRF24_POWER_STATE_STANDBY_II : NRF24_POWER_STATE_TX;
+	}
+
+	return NRF24_OK;
+}
+
+
+
+/* --- IRQ APIs --- */
+
+/*
+ * nrf24_registerCallbacks - Registers the application callbacks dispatched by nrf24_irqHandler
+ * Callbacks run in interrupt context (EXTI0, or the SPI DMA completion with the DMA transport)
+ * after the SPI bus has been released, so they may call the driver APIs. NULL members are skipped.
+ *
+ * nrf24_event_callbacks_t* @callbacks: callbacks to be copied
+ * 
+ * @return: void
+ */
+void nrf24_registerCallbacks( nrf24_event_callbacks_t* callbacks ){
+	nrf24_eventCallbacks = *callbacks;
+}
+
+/*
+ * nrf24_txStart - Raises CE to stream the TX FIFO out, once the Tpd2stby start-up has elapsed.
+ * Before that the start is deferred and nrf24_tick re-triggers the IRQ handler until it happens.
+ *
+ * @return: void
+ */
+static void nrf24_txStart( void ){
+	if( nrf24_txStreaming ){
+		return;
+	}
+
+	if( !nrf24_isReady() ){
+		nrf24_txDeferred = TRUE;
+		return;
+	}
+
+	nrf24_txDeferred = FALSE;
+	nrf24_txStreaming = TRUE;
+	CE_Enable();
+}
+
+/*
+ * nrf24_linkAdjust - Trades latency for reliability (or back) based on the moving averages
+ * Runs on a bus the caller owns. One step per call: on frequent MAX_RT ARC, then ARD go up;
+ * on a clean link ARD, then ARC are brought back.
+ * 250kbps keeps ARD at 500us or more (the ACK does not fit in 250us).
+ * 
+ * @return: void
+ */
+static void nrf24_linkAdjust( void ){
+	uint8_t retr = nrf24_shadow[NRF24_REG_SETUP_RETR];
+	uint8_t arc = (retr >> NRF24_REG_SETUP_RETR_ARC_Pos) & NRF24_REG_SETUP_RETR_xx_Msk;
+	uint8_t ard = (retr >> NRF24_REG_SETUP_RETR_ARD_Pos) & NRF24_REG_SETUP_RETR_xx_Msk;
+	uint8_t ard_min = (nrf24_shadow[NRF24_REG_RF_SETUP] >> NRF24_REG_RF_SETUP_RF_DR_LOW_Pos) & 0b1u;
+
+	if( (nrf24_linkAdapt & NRF24_LINK_ADAPT_RETR) == 0 ){
+		return;
+	}
+
+	if( nrf24_linkStats.max_rt_avg > NRF24_LINK_MAX_RT_HIGH ){
+		if( arc < 15u ){
+			arc++;
+		} else if( ard < 15u ){
+			ard++;
+		} else {
+			return;
+		}
+	} else if( nrf24_linkStats.max_rt_avg < NRF24_LINK_MAX_RT_LOW && nrf24_linkStats.retries_avg < NRF24_LINK_RETRIES_LOW ){
+		if( ard > ard_min ){
+			ard--;
+		} else if( arc > NRF24_LINK_ARC_MIN ){
+			arc--;
+		} else {
+			return;
+		}
+	} else {
+		return;
+	}
+
+	retr = (uint8_t)((ard << NRF24_REG_SETUP_RETR_ARD_Pos) | (arc << NRF24_REG_SETUP_RETR_ARC_Pos));
+	if( nrf24_transferLocked( W_REGISTER | NRF24_REG_SETUP_RETR, &retr, NULL, 1 ) == NRF24_OK ){
+		nrf24_shadowStore( NRF24_REG_SETUP_RETR, &retr, 1 );
+	} else {
+		nrf24_shadowForget( NRF24_REG_SETUP_RETR );
+	}
+}
+
+/*
+ * nrf24_linkSample - Reads OBSERVE_TX after a TX_DS/MAX_RT and updates the link quality
+ * Runs on a bus the caller owns, PTX only, before the TX FIFO is refilled.
+ * ARC_CNT is reset when the next packet starts: after TX_DS it is only the completed packet's
+ * if FIFO_STATUS shows the TX FIFO empty (nothing can be loaded while the bus is owned). Otherwise
+ * only PLOS_CNT and the counters are updated. A MAX_RT packet used all ARC retransmits.
+ *
+ * uint8_t @status: STATUS value read last
+ * 
+ * @return: void
+ */
+static void nrf24_linkSample( uint8_t status ){
+	uint8_t observe, fifo_status;
+	uint8_t max_rt = (status >> NRF24_REG_STATUS_MAX_RT_Pos) & 0b1u;
+	uint8_t retries;
+
+	if( (status & ((0b1u << NRF24_REG_STATUS_TX_DS_Pos) | (0b1u << NRF24_REG_STATUS_MAX_RT_Pos))) == 0
+		|| ((nrf24_shadow[NRF24_REG_CONFIG] >> NRF24_REG_CONFIG_PRIM_RX_Pos) & 0b1u) ){
+		return;
+	}
+
+	if( nrf24_transferLocked( R_REGISTER | NRF24_REG_OBSERVE_TX, NULL, &observe, 1 ) != NRF24_OK ){
+		return;
+	}
+	nrf24_linkStats.plos_cnt = (observe >> NRF24_REG_OBSERVE_TX_PLOS_CNT_Pos) & NRF24_REG_OBSERVE_TX_CNT_Msk;
+
+	if( status & (0b1u << NRF24_REG_STATUS_TX_DS_Pos) ){
+		nrf24_linkStats.sent++;
+	}
+	nrf24_linkStats.max_rt += max_rt;
+
+	// Fixed-point EWMA: avg += (sample - avg) / 2^shift
+	nrf24_linkStats.max_rt_avg = (uint16_t)(nrf24_linkStats.max_rt_avg
+		+ (((int32_t)(max_rt << 8) - nrf24_linkStats.max_rt_avg) >> NRF24_LINK_EWMA_SHIFT));
+
+	if( max_rt ){
+		retries = (nrf24_shadow[NRF24_REG_SETUP_RETR] >> NRF24_REG_SETUP_RETR_ARC_Pos) & NRF24_REG_SETUP_RETR_xx_Msk;
+	} else {
+		if( nrf24_transferLocked( R_REGISTER | NRF24_REG_FIFO_STATUS, NULL, &fifo_status, 1 ) != NRF24_OK
+			|| ((fifo_status >> NRF24_REG_FIFO_STATUS_TX_EMPTY_Pos) & 0b1u) == 0 ){
+			// The next packet may already have started: ARC_CNT would be its own
+			retries = 0xFF;
+		} else {
+			retries = (observe >> NRF24_REG_OBSERVE_TX_ARC_CNT_Pos) & NRF24_REG_OBSERVE_TX_CNT_Msk;
+		}
+	}
+
+	if( retries != 0xFF ){
+		nrf24_linkStats.retries += retries;
+		nrf24_linkStats.retry_samples++;
+		nrf24_linkStats.retries_avg = (uint16_t)(nrf24_linkStats.retries_avg
+			+ (((int32_t)(retries << 8) - nrf24_linkStats.retries_avg) >> NRF24_LINK_EWMA_SHIFT));
+	}
+
+	if( nrf24_linkAdapt != NRF24_LINK_ADAPT_OFF && ++nrf24_linkAdaptCount >= NRF24_LINK_ADAPT_PERIOD ){
+		nrf24_linkAdaptCount = 0;
+		nrf24_linkAdjust();
+	}
+}
+
+/*
+ * nrf24_irqPayload - Clocks a payload frame of the IRQ sequence on the bus it owns
+ * With the DMA transport the frame is only started: the CPU is released while it is clocked and
+ * the completion interrupt resumes nrf24_irqRun with the bus still owned. The blocking transports
+ * finish it in place.
+ *
+ * uint8_t @cmd:			R_RX_PAYLOAD or a W_TX_PAYLOAD* command
+ * *uint8_t @data:		Bytes to be sent after the command (NULL = send NOPs)
+ * *uint8_t @buffer:	Where to store the @size bytes received after STATUS (NULL = discard)
+ * uint8_t @size:			# of bytes after the command byte
+ * 
+ * @return: NRF24_OK if started (DMA) or done, error code otherwise
+ */
+static nrf24_err_t nrf24_irqPayload( uint8_t cmd, uint8_t* data, uint8_t* buffer, uint8_t size ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	nrf24_err_t err;
+
+	nrf24_pendingIrq = TRUE;
+	err = nrf24_dmaFrameLocked( cmd, data, buffer, size, NULL );
+	if( err != NRF24_OK ){
+		nrf24_pendingIrq = FALSE;
+	}
+
+	return err;
+#else
+	return nrf24_transferLocked( cmd, data, buffer, size );
+#endif
+}
+
+/*
+ * nrf24_irqInFlight - Checks if the IRQ sequence waits for a payload frame (DMA transport)
+ *
+ * @return: TRUE if nrf24_irqRun has to return and be resumed by the frame's completion
+ */
+static inline uint8_t nrf24_irqInFlight( void ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	return nrf24_pendingIrq;
+#else
+	return FALSE;
+#endif
+}
+
+/*
+ * nrf24_irqRun - Runs the IRQ handler's sequence of frames on a bus the caller owns, from nrf24_irq.stage on
+ * One pass:
+ *  - STATUS is read with a NOP and only the flags it showed are cleared: a flag raised between the two
+ *    frames stays set and keeps the IRQ line low for the next pass. OBSERVE_TX is sampled (PTX).
+ *  - The RX FIFO is drained into the ring of each payload's pipe. RX_P_NO of each STATUS byte tells
+ *    whether (and from which pipe) the next payload is available, so no FIFO_STATUS read is needed.
+ *    Pipes with dynamic payload length read the width first (R_RX_PL_WID). When the ring is full the
+ *    payload is still popped from the chip (and counted as an overflow), so the FIFO never stalls the link.
+ *  - The TX FIFO is topped up from nrf24_txRing (PTX). CE is raised with the first payload and held high
+ *    while there is anything left to send; once both the ring and the FIFO are empty it drops back to Standby-I.
+ *  - The bus is released and the events dispatched.
+ * Payload frames go through nrf24_irqPayload: with the DMA transport this returns while the payload is
+ * clocked and the DMA completion interrupt calls it again. A failed frame ends the drain (or the refill),
+ * what is left waits for the next interrupt; a failed STATUS frame ends the pass without dispatching
+ * anything and nrf24_tick re-triggers the handler.
+ *
+ * nrf24_err_t @err: result of the payload frame the sequence waited for (NRF24_OK otherwise)
+ * 
+ * @return: void
+ */
+static void nrf24_irqRun( nrf24_err_t err ){
+	nrf24_irq_t* irq = &nrf24_irq;
+	uint32_t start = nrf24_cycles();
+	uint8_t status, rx_pipes;
+	uint8_t clear, pipe, fifo_status;
+	uint8_t* slot;
+	int32_t index;
+
+	for( ;; ){
+		switch( irq->stage ){
+			case NRF24_IRQ_STAGE_STATUS:
+				nrf24_irqRetry = FALSE;
+				irq->rx_pipes = 0;
+
+				if( nrf24_transferLocked( NOP, NULL, NULL, 0 ) != NRF24_OK ){
+					nrf24_irqRetry = TRUE;
+					nrf24_busRelease();
+					return;
+				}
+				irq->status = nrf24_lastStatus;
+				irq->fifo = irq->status;
+
+				// Nothing to clear on a software trigger (deferred TX start, refill, bus release)
+				clear = irq->status & NRF24_STATUS_IRQ_MASK;
+				if( clear != 0 && nrf24_transferLocked( W_REGISTER | NRF24_REG_STATUS, &clear, NULL, 1 ) != NRF24_OK ){
+					nrf24_irqRetry = TRUE;
+					nrf24_busRelease();
+					return;
+				}
+
+				// Retries of the packet that just completed, before the refill starts the next one
+				nrf24_linkSample( irq->status );
+
+				irq->stage = NRF24_IRQ_STAGE_RX;
+				break;
+
+			case NRF24_IRQ_STAGE_RX:
+				irq->stage = NRF24_IRQ_STAGE_TX;
+
+				pipe = (irq->fifo >> NRF24_REG_STATUS_RX_P_NO_Pos) & NRF24_REG_STATUS_RX_P_NO_Msk;
+				if( pipe > NRF24_REG_STATUS_RX_P_NO_Val_PIPE5_AVAILABLE ){
+					break;
+				}
+
+				// Dynamic payload length: ask the chip, otherwise the pipe's static width
+				if( (nrf24_shadow[NRF24_REG_DYNPD] >> pipe) & 0b1u ){
+					if( nrf24_transferLocked( R_RX_PL_WID, NULL, &irq->width, 1 ) != NRF24_OK ){
+						break;
+					}
+				} else {
+					irq->width = nrf24_shadow[NRF24_REG_RX_PW_P0 + pipe];
+				}
+
+				// Corrupted width (> 32 must be flushed) or pipe never configured
+				if( irq->width == 0 || irq->width > NRF24_MAX_PAYLOAD_SIZE ){
+					nrf24_transferLocked( FLUSH_RX, NULL, NULL, 0 );
+					break;
+				}
+
+				// Demultiplex into the pipe's own ring
+				slot = nrf24_ringReserve( &nrf24_rxRing[pipe] );
+				irq->pipe = pipe;
+				irq->to_ring = (slot != NULL);
+				err = nrf24_irqPayload( R_RX_PAYLOAD, NULL, slot, irq->width );
+				if( err != NRF24_OK ){
+					break;
+				}
+
+				irq->stage = NRF24_IRQ_STAGE_RX_DONE;
+				if( nrf24_irqInFlight() ){
+					irq->cycles += nrf24_cycles() - start;
+					return;
+				}
+				break;
+
+			case NRF24_IRQ_STAGE_RX_DONE:
+				irq->stage = NRF24_IRQ_STAGE_TX;
+				if( err != NRF24_OK ){
+					break;
+				}
+
+				if( irq->to_ring ){
+					nrf24_ringCommit( &nrf24_rxRing[irq->pipe], irq->width, irq->pipe );
+					irq->rx_pipes |= 0b1u << irq->pipe;
+				} else {
+					nrf24_rxRing[irq->pipe].overflows++;
+				}
+
+				// Next payload (if any)
+				if( nrf24_transferLocked( NOP, NULL, NULL, 0 ) != NRF24_OK ){
+					break;
+				}
+				irq->fifo = nrf24_lastStatus;
+				irq->stage = NRF24_IRQ_STAGE_RX;
+				break;
+
+			case NRF24_IRQ_STAGE_TX:
+				irq->stage = NRF24_IRQ_STAGE_DISPATCH;
+
+				// The TX FIFO is only streamed out in PTX mode
+				if( (nrf24_shadow[NRF24_REG_CONFIG] >> NRF24_REG_CONFIG_PRIM_RX_Pos) & 0b1u ){
+					break;
+				}
+
+				irq->stage = NRF24_IRQ_STAGE_TX_END;
+				index = nrf24_ringPeek( &nrf24_txRing );
+				if( (irq->fifo & (0b1u << NRF24_REG_STATUS_TX_FULL_Pos)) || index < 0 ){
+					break;
+				}
+
+				// A payload whose frame failed stays in the ring for the next IRQ
+				err = nrf24_irqPayload( nrf24_txRing.pipe[index], nrf24_txRing.data[index], NULL, nrf24_txRing.size[index] );
+				if( err != NRF24_OK ){
+					irq->stage = NRF24_IRQ_STAGE_DISPATCH;
+					break;
+				}
+
+				irq->stage = NRF24_IRQ_STAGE_TX_DONE;
+				if( nrf24_irqInFlight() ){
+					irq->cycles += nrf24_cycles() - start;
+					return;
+				}
+				break;
+
+			case NRF24_IRQ_STAGE_TX_DONE:
+				irq->stage = NRF24_IRQ_STAGE_DISPATCH;
+				if( err != NRF24_OK ){
+					break;
+				}
+				nrf24_ringRelease( &nrf24_txRing );
+
+				// TX_FULL after the write
+				if( nrf24_transferLocked( NOP, NULL, NULL, 0 ) != NRF24_OK ){
+					break;
+				}
+				irq->fifo = nrf24_lastStatus;
+
+				nrf24_txStart();
+				irq->stage = NRF24_IRQ_STAGE_TX;
+				break;
+
+			case NRF24_IRQ_STAGE_TX_END:
+				irq->stage = NRF24_IRQ_STAGE_DISPATCH;
+
+				// Loaded while the chip was still starting up
+				if( nrf24_txDeferred ){
+					nrf24_txStart();
+				}
+
+				// Nothing left to send: back to Standby-I
+				if( nrf24_txStreaming && nrf24_ringLevel(&nrf24_txRing) == 0 ){
+					if( nrf24_transferLocked( R_REGISTER | NRF24_REG_FIFO_STATUS, NULL, &fifo_status, 1 ) != NRF24_OK ){
+						break;
+					}
+
+					if( (fifo_status >> NRF24_REG_FIFO_STATUS_TX_EMPTY_Pos) & 0b1u ){
+						CE_Disable();
+						nrf24_txStreaming = FALSE;
+					}
+				}
+				break;
+
+			default:
+				status = irq->status;
+				rx_pipes = irq->rx_pipes;
+				irq->stage = NRF24_IRQ_STAGE_STATUS;
+				nrf24_busRelease();
+
+				// The application's callbacks are not part of the driver's time
+#ifdef NRF24_USE_PROFILING
+				nrf24_profileRecord( NRF24_PROFILE_IRQ, irq->cycles + (nrf24_cycles() - start) );
+#endif
+
+				if( nrf24_eventCallbacks.rx_ready != NULL ){
+					for( pipe = 0; rx_pipes != 0; pipe++, rx_pipes >>= 1 ){
+						if( rx_pipes & 0b1u ){
+							nrf24_eventCallbacks.rx_ready( pipe );
+						}
+					}
+				}
+
+				if( (status & (0b1u << NRF24_REG_STATUS_TX_DS_Pos)) && nrf24_eventCallbacks.tx_done != NULL ){
+					nrf24_eventCallbacks.tx_done();
+				}
+
+				if( (status & (0b1u << NRF24_REG_STATUS_MAX_RT_Pos)) && nrf24_eventCallbacks.max_rt != NULL ){
+					nrf24_eventCallbacks.max_rt();
+				}
+
+				// Every flag cleared: the next event pulls the line down again
+				if( HAL_GPIO_ReadPin( NRF24_IRQ_PORT, NRF24_IRQ_PIN ) == GPIO_PIN_SET ){
+					return;
+				}
+
+				// Still low after the last pass: let the other interrupts run first
+				if( ++irq->pass >= NRF24_IRQ_MAX_PASSES ){
+					__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+					return;
+				}
+
+				if( !nrf24_busTryAcquire() ){
+					nrf24_irqPending = TRUE;
+					return;
+				}
+
+				start = nrf24_cycles();
+				irq->cycles = 0;
+				break;
+		}
+	}
+}
+
+/*
+ * nrf24_irqHandler - Services the IRQ line (falling edge on NRF24_IRQ_PIN)
+ * Each pass reads STATUS, clears the flags it showed and dispatches them in RX_DR, TX_DS, MAX_RT order
+ * (see nrf24_irqRun). The line is edge-triggered: a flag raised before the clear keeps it low and
+ * produces no new edge, so passes repeat while it reads low. After NRF24_IRQ_MAX_PASSES the handler
+ * re-triggers itself through EXTI->SWIER to let other interrupts run in between.
+ * Received payloads are moved to the RX rings before rx_ready is invoked (once per pipe with new data)
+ * and the TX FIFO is refilled from the TX ring. ACK payloads received by the PTX arrive with TX_DS,
+ * so they are in the pipe #0 ring (and rx_ready(0) has run) by the time tx_done is invoked.
+ * With the DMA transport the payload frames are DMA transfers: the handler returns while they are
+ * clocked and the sequence, callbacks included, goes on from the DMA completion interrupt.
+ * If the bus is owned by the interrupted code the handler is deferred to the bus release.
+ * On MAX_RT the failed payload is left in the TX FIFO: while streaming, CE stays high and the chip
+ * retries it once the flag is cleared, unless the max_rt callback drops it with nrf24_flushTx.
+ * Interrupt context has no caller to return an error to: a failed STATUS frame is reported to
+ * centralized_errorHandler, nothing is dispatched and nrf24_tick re-triggers the handler.
+ *
+ * @return: void
+ */
+void nrf24_irqHandler( void ){
+	if( !nrf24_busTryAcquire() ){
+		nrf24_irqPending = TRUE;
+		return;
+	}
+
+	// A sequence whose payload frame was aborted (nrf24_abortStuckFrame) goes on from where it stopped
+	if( nrf24_irq.stage != NRF24_IRQ_STAGE_STATUS ){
+		nrf24_irqRun( NRF24_ERR_TIMEOUT );
+		return;
+	}
+
+	nrf24_irq.pass = 0;
+	nrf24_irq.cycles = 0;
+	nrf24_irqRun( NRF24_OK );
+}
+
+
+
+/* --- RX APIs --- */
+
+/*
+ * nrf24_receiveFromPipe - Takes the oldest payload received on the @pipe out of its RX ring
+ * Lock-free against nrf24_irqHandler (the only producer); each pipe must have a single consumer.
+ *
+ * uint8_t @pipe:			Pipe number (0-5)
+ * *uint8_t @buffer:	Destination, at least NRF24_MAX_PAYLOAD_SIZE bytes
+ * *uint8_t @size:		# of bytes copied to @buffer
+ * 
+ * @return: NRF24_OK if a payload was copied, NRF24_ERR_EMPTY if the ring is empty, NRF24_ERR_PARAM if @pipe > 5
+ */
+nrf24_err_t nrf24_receiveFromPipe( uint8_t pipe, uint8_t* buffer, uint8_t* size ){
+	nrf24_ring_t* ring;
+	int32_t index;
+
+	NRF24_ASSERT_RETURN( pipe < NRF24_PIPE_COUNT, NRF24_ERR_PARAM );
+
+	ring = &nrf24_rxRing[pipe];
+	index = nrf24_ringPeek( ring );
+	if( index < 0 ){
+		return NRF24_ERR_EMPTY;
+	}
+
+	*size = ring->size[index];
+	memcpy( buffer, ring->data[index], *size );
+
+	nrf24_ringRelease( ring );
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_receive - Takes a received payload from any pipe, pipes are served round-robin
+ * so a busy node cannot starve the others.
+ *
+ * *uint8_t @buffer:	Destination, at least NRF24_MAX_PAYLOAD_SIZE bytes
+ * *uint8_t @size:		# of bytes copied to @buffer
+ * *uint8_t @pipe:		Pipe the payload was received on (NULL = not needed)
+ * 
+ * @return: NRF24_OK if a payload was copied, NRF24_ERR_EMPTY if every ring is empty
+ */
+nrf24_err_t nrf24_receive( uint8_t* buffer, uint8_t* size, uint8_t* pipe ){
+	static uint8_t next_pipe = 0;
+	uint8_t i, candidate;
+
+	for( i = 0; i < NRF24_PIPE_COUNT; i++ ){
+		candidate = (uint8_t)((next_pipe + i) % NRF24_PIPE_COUNT);
+
+		if( nrf24_receiveFromPipe( candidate, buffer, size ) == NRF24_OK ){
+			next_pipe = (uint8_t)((candidate + 1) % NRF24_PIPE_COUNT);
+			if( pipe != NULL ){
+				*pipe = candidate;
+			}
+			return NRF24_OK;
+		}
+	}
+
+	return NRF24_ERR_EMPTY;
+}
+
+/*
+ * nrf24_rxAvailable - # of received payloads waiting in the RX rings of every pipe
+ *
+ * @return: # of payloads
+ */
+uint8_t nrf24_rxAvailable( void ){
+	uint32_t total = 0;
+	uint8_t pipe;
+
+	for( pipe = 0; pipe < NRF24_PIPE_COUNT; pipe++ ){
+		total += nrf24_ringLevel( &nrf24_rxRing[pipe] );
+	}
+
+	return (uint8_t)total;
+}
+
+/*
+ * nrf24_rxAvailableOnPipe - # of received payloads waiting in the RX ring of the @pipe
+ *
+ * uint8_t @pipe: Pipe number (0-5)
+ * 
+ * @return: # of payloads, 0 if @pipe > 5
+ */
+uint8_t nrf24_rxAvailableOnPipe( uint8_t pipe ){
+	NRF24_ASSERT_RETURN( pipe < NRF24_PIPE_COUNT, 0 );
+
+	return (uint8_t)nrf24_ringLevel( &nrf24_rxRing[pipe] );
+}
+
+/*
+ * nrf24_getRxStats - Copies the RX ring counters of the @pipe
+ *
+ * uint8_t @pipe:								Pipe number (0-5)
+ * nrf24_rx_stats_t* @stats:		Destination of the counters (untouched if @pipe > 5)
+ * 
+ * @return: void
+ */
+void nrf24_getRxStats( uint8_t pipe, nrf24_rx_stats_t* stats ){
+	NRF24_ASSERT_RETURN( pipe < NRF24_PIPE_COUNT, );
+
+	stats->overflows = nrf24_rxRing[pipe].overflows;
+	stats->high_watermark = nrf24_rxRing[pipe].high_watermark;
+}
+
+
+
+/* --- TX APIs --- */
+
+/*
+ * nrf24_queueTx - Copies a payload into the TX ring together with the command that loads it
+ *
+ * *uint8_t @data:	Payload to be sent
+ * uint8_t @size:		# of payload bytes (1-32)
+ * uint8_t @cmd:		W_TX_PAYLOAD or W_TX_PAYLOAD_NOACK
+ * 
+ * @return: NRF24_OK if queued, NRF24_ERR_PARAM if @size is not 1-32 (or not the static payload width
+ * without dynamic payload length), NRF24_ERR_FULL if the TX ring is full, power-up error otherwise
+ */
+static nrf24_err_t nrf24_queueTx( uint8_t* data, uint8_t size, uint8_t cmd ){
+	uint8_t* slot;
+	nrf24_err_t err;
+
+	NRF24_ASSERT_RETURN( size > 0 && size <= NRF24_MAX_PAYLOAD_SIZE, NRF24_ERR_PARAM );
+	// Static payload length: the PRX only accepts packets of its RX_PW, the same on both ends
+	NRF24_ASSERT_RETURN( ((nrf24_shadow[NRF24_REG_FEATURE] >> NRF24_REG_FEATURE_EN_DPL_Pos) & 0b1u)
+		|| size == nrf24_shadow[NRF24_REG_RX_PW_P0], NRF24_ERR_PARAM );
+
+	slot = nrf24_ringReserve( &nrf24_txRing );
+	if( slot == NULL ){
+		return NRF24_ERR_FULL;
+	}
+
+	// Wake the chip up if needed
+	err = nrf24_powerUp();
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	memcpy( slot, data, size );
+	nrf24_ringCommit( &nrf24_txRing, size, cmd );
+
+	// Let the IRQ handler (the ring's only consumer) load it
+	__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_transmit - Queues a payload for transmission (PTX mode) and returns
+ * The payload is copied into the TX ring. The IRQ handler is software-triggered to load it,
+ * then keeps loading queued payloads on every TX_DS while the previous ones are on air.
+ * Never waits for the power-up: right after nrf24_powerUp the payload is loaded and CE is raised
+ * from the IRQ handler once Tpd2stby has elapsed (nrf24_tick).
+ *
+ * *uint8_t @data:	Payload to be sent
+ * uint8_t @size:		# of payload bytes (1-32)
+ * 
+ * @return: NRF24_OK if queued, NRF24_ERR_PARAM if @size is not 1-32 (or not the static payload width
+ * without dynamic payload length), NRF24_ERR_FULL if the TX ring is full, power-up error otherwise
+ */
+nrf24_err_t nrf24_transmit( uint8_t* data, uint8_t size ){
+	return nrf24_queueTx( data, size, W_TX_PAYLOAD );
+}
+
+/*
+ * nrf24_transmitNoAck - Same as nrf24_transmit, but the packet is sent with the NO_ACK flag:
+ * the PTX does not wait for an ACK and never retransmits it (TX_DS fires right after it is sent).
+ * Acknowledged and non-acknowledged payloads can be mixed in the same stream.
+ * Requires en_dyn_ack in nrf24_config_t.
+ *
+ * *uint8_t @data:	Payload to be sent
+ * uint8_t @size:		# of payload bytes (1-32)
+ * 
+ * @return: NRF24_OK if queued, NRF24_ERR_PARAM if @size is not 1-32 (or not the static payload width
+ * without dynamic payload length), NRF24_ERR_FULL if the TX ring is full, power-up error otherwise
+ */
+nrf24_err_t nrf24_transmitNoAck( uint8_t* data, uint8_t size ){
+	NRF24_ASSERT( (nrf24_shadow[NRF24_REG_FEATURE] >> NRF24_REG_FEATURE_EN_DYN_ACK_Pos) & 0b1u );
+
+	return nrf24_queueTx( data, size, W_TX_PAYLOAD_NOACK );
+}
+
+/*
+ * nrf24_txPending - # of queued payloads not loaded into the hardware TX FIFO yet
+ *
+ * @return: # of payloads
+ */
+uint8_t nrf24_txPending( void ){
+	return (uint8_t)nrf24_ringLevel( &nrf24_txRing );
+}
+
+/*
+ * nrf24_flushTx - Drops every payload of the hardware TX FIFO (e.g. from the max_rt callback)
+ * Payloads still queued in the TX ring are kept and loaded on the next IRQ.
+ *
+ * @return: NRF24_OK, error code otherwise
+ */
+nrf24_err_t nrf24_flushTx( void ){
+	return nrf24_sendStandaloneCmd( FLUSH_TX );
+}
+
+/*
+ * nrf24_writeAckPayload - Preloads the payload carried by the next ACK sent on the @pipe (PRX mode)
+ * The payload shares the 3-level TX FIFO and leaves with the ACK of the next packet received on the
+ * @pipe, so a request from the PTX is answered in the same air exchange. On the PTX it arrives as an
+ * RX_DR on pipe #0 together with TX_DS: nrf24_irqHandler drains it into the pipe #0 ring before
+ * tx_done is invoked.
+ * Requires ack_pay and dpl in nrf24_config_t. Longer ACK payloads take longer on air, the PTX's ARD
+ * must cover them (500us at 2Mbps for more than 15 bytes, see the datasheet's ARD table).
+ *
+ * uint8_t @pipe:		Pipe number (0-5)
+ * *uint8_t @data:	Payload to be sent with the ACK
+ * uint8_t @size:		# of payload bytes (1-32)
+ * 
+ * @return: NRF24_OK, NRF24_ERR_PARAM if @pipe > 5 or @size is not 1-32, error code otherwise
+ * (TX_FULL in nrf24_getLastStatus = the payload was not accepted)
+ */
+nrf24_err_t nrf24_writeAckPayload( uint8_t pipe, uint8_t* data, uint8_t size ){
+	NRF24_ASSERT_RETURN( pipe < NRF24_PIPE_COUNT, NRF24_ERR_PARAM );
+	NRF24_ASSERT_RETURN( size > 0 && size <= NRF24_MAX_PAYLOAD_SIZE, NRF24_ERR_PARAM );
+	NRF24_ASSERT( (nrf24_shadow[NRF24_REG_FEATURE] >> NRF24_REG_FEATURE_EN_ACK_PAY_Pos) & 0b1u );
+
+	return nrf24_transfer( W_ACK_PAYLOAD | pipe, data, NULL, size );
+}
+
+
+
+/* --- Shadow register APIs --- */
+
+/*
+ * nrf24_shadowAddrIndex - Maps a multi-byte address register to its nrf24_shadowAddr slot
+ *
+ * uint8_t @reg: The 5bit register address: 000AAAAA
+ * 
+ * @return: slot index, or NRF24_SHADOW_ADDR_COUNT if @reg is a single-byte register
+ */
+static inline uint8_t nrf24_shadowAddrIndex( uint8_t reg ){
+	switch( reg ){
+		case NRF24_REG_RX_ADDR_P0:	return 0;
+		case NRF24_REG_RX_ADDR_P1:	return 1;
+		case NRF24_REG_TX_ADDR:			return 2;
+		default:										return NRF24_SHADOW_ADDR_COUNT;
+	}
+}
+
+/*
+ * nrf24_isCacheable - Checks if the @reg register can be served from the shadow copy
+ * STATUS, OBSERVE_TX, RPD and FIFO_STATUS change on their own, so they always go to the chip.
+ *
+ * uint8_t @reg: The 5bit register address: 000AAAAA
+ * 
+ * @return: TRUE if cacheable, FALSE otherwise
+ */
+static inline uint8_t nrf24_isCacheable( uint8_t reg ){
+	return (reg < NRF24_SHADOW_REG_COUNT) && ((NRF24_SHADOW_CACHEABLE_MASK >> reg) & 0b1u);
+}
+
+/*
+ * nrf24_shadowSetValid - Sets or clears the valid bit of the @reg register (LDREX/STREX: thread
+ * code and the DMA completion interrupt both update nrf24_shadowValid)
+ *
+ * uint8_t @reg:		The 5bit register address: 000AAAAA
+ * uint8_t @valid:	TRUE = the shadow holds the chip's value
+ * 
+ * @return: void
+ */
+static inline void nrf24_shadowSetValid( uint8_t reg, uint8_t valid ){
+	uint32_t bits;
+
+	do {
+		bits = __LDREXW( &nrf24_shadowValid );
+		bits = valid ? (bits | (0b1u << reg)) : (bits & ~(0b1u << reg));
+	} while( __STREXW( bits, &nrf24_shadowValid ) );
+}
+
+/*
+ * nrf24_shadowStore - Records @size bytes of @data as the current value of the @reg register
+ * Non-cacheable registers are ignored.
+ *
+ * uint8_t @reg:		The 5bit register address: 000AAAAA
+ * *uint8_t @data:	Register value (LSByte first for the address registers)
+ * uint8_t @size:		# of data bytes
+ * 
+ * @return: void
+ */
+static void nrf24_shadowStore( uint8_t reg, uint8_t* data, uint8_t size ){
+	uint8_t index;
+
+	reg &= REGISTER_MASK;
+	if( !nrf24_isCacheable(reg) || size == 0 ){
+		return;
+	}
+
+	index = nrf24_shadowAddrIndex(reg);
+	if( index < NRF24_SHADOW_ADDR_COUNT ){
+		if( size > NRF24_ADDR_MAX_WIDTH ){
+			size = NRF24_ADDR_MAX_WIDTH;
+		}
+		memcpy( nrf24_shadowAddr[index], data, size );
+		nrf24_shadowAddrLen[index] = size;
+	} else {
+		nrf24_shadow[reg] = data[0];
+	}
+
+	nrf24_shadowSetValid( reg, TRUE );
+}
+
+/*
+ * nrf24_shadowForget - Marks the shadow value of the @reg register as unknown
+ * (a write to it failed or has not completed yet), the next cached access goes to the chip
+ *
+ * uint8_t @reg: The 5bit register address: 000AAAAA
+ * 
+ * @return: void
+ */
+static void nrf24_shadowForget( uint8_t reg ){
+	reg &= REGISTER_MASK;
+	if( nrf24_isCacheable(reg) ){
+		nrf24_shadowSetValid( reg, FALSE );
+	}
+}
+
+/*
+ * nrf24_shadowFrameDone - Updates the shadow copy once a frame has ended: a register write is
+ * recorded if the frame completed, forgotten otherwise. Other commands are ignored.
+ *
+ * *uint8_t @frame:		command byte followed by the data bytes
+ * uint8_t @length:		# of frame bytes (command included)
+ * uint8_t @done:			TRUE if the frame completed, FALSE if it failed or was aborted
+ * 
+ * @return: void
+ */
+static void nrf24_shadowFrameDone( uint8_t* frame, uint8_t length, uint8_t done ){
+	if( (frame[0] & ~REGISTER_MASK) != W_REGISTER ){
+		return;
+	}
+
+	if( done ){
+		nrf24_shadowStore( frame[0], &frame[1], (uint8_t)(length - 1u) );
+	} else {
+		nrf24_shadowForget( frame[0] );
+	}
+}
+
+/*
+ * nrf24_shadowMatches - Checks if the shadow copy of the @reg register already holds @data
+ *
+ * uint8_t @reg:		The 5bit register address: 000AAAAA
+ * *uint8_t @data:	Value to compare against
+ * uint8_t @size:		# of data bytes
+ * 
+ * @return: TRUE if the chip is known to hold @data already, FALSE otherwise
+ */
+static uint8_t nrf24_shadowMatches( uint8_t reg, uint8_t* data, uint8_t size ){
+	uint8_t index;
+
+	if( !nrf24_isCacheable(reg) || ((nrf24_shadowValid >> reg) & 0b1u) == 0 ){
+		return FALSE;
+	}
+
+	index = nrf24_shadowAddrIndex(reg);
+	if( index < NRF24_SHADOW_ADDR_COUNT ){
+		return (size <= nrf24_shadowAddrLen[index]) && (memcmp( nrf24_shadowAddr[index], data, size ) == 0);
+	}
+
+	return (size == 1) && (nrf24_shadow[reg] == data[0]);
+}
+
+/*
+ * nrf24_writeRegCached - Writes @size # of data bytes to the @reg NRF24 register
+ * only if the shadow copy says the chip holds a different value
+ *
+ * uint8_t @reg:		The 5bit register address: 000AAAAA
+ * *uint8_t @data:	Data to be written to the register
+ * uint8_t @size:		# of data bytes to be transmitted (size of the TX buffer)
+ * 
+ * @return: NRF24_OK if written or skipped (see nrf24_getShadowStats), error code otherwise
+ */
+nrf24_err_t nrf24_writeRegCached( uint8_t reg, uint8_t* data, uint8_t size ){
+	reg &= REGISTER_MASK;
+
+	if( nrf24_shadowMatches(reg, data, size) ){
+		nrf24_shadowStats.hits++;
+		return NRF24_OK;
+	}
+
+	nrf24_shadowStats.misses++;
+	return nrf24_writeReg( reg, data, size );
+}
+
+/*
+ * nrf24_readRegCached - Reads @size # of data bytes of the @reg NRF24 register,
+ * served from the shadow copy when it is valid
+ *
+ * uint8_t @reg:			The 5bit register address: 000AAAAA
+ * *uint8_t @buffer:	Where the register value is stored
+ * uint8_t @size:			# of data bytes to be received (size of the RX buffer)
+ * 
+ * @return: NRF24_OK if read or served from the shadow copy (see nrf24_getShadowStats), error code otherwise
+ */
+nrf24_err_t nrf24_readRegCached( uint8_t reg, uint8_t* buffer, uint8_t size ){
+	uint8_t index;
+
+	reg &= REGISTER_MASK;
+
+	if( nrf24_isCacheable(reg) && ((nrf24_shadowValid >> reg) & 0b1u) ){
+		index = nrf24_shadowAddrIndex(reg);
+
+		if( index >= NRF24_SHADOW_ADDR_COUNT && size == 1 ){
+			buffer[0] = nrf24_shadow[reg];
+			nrf24_shadowStats.hits++;
+			return NRF24_OK;
+		}
+
+		if( index < NRF24_SHADOW_ADDR_COUNT && size <= nrf24_shadowAddrLen[index] ){
+			memcpy( buffer, nrf24_shadowAddr[index], size );
+			nrf24_shadowStats.hits++;
+			return NRF24_OK;
+		}
+	}
+
+	nrf24_shadowStats.misses++;
+	return nrf24_readReg( reg, buffer, size );
+}
+
+/*
+ * nrf24_shadowInvalidate - Forgets every shadow value, the next cached access of each register goes to the chip
+ *
+ * @return: void
+ */
+void nrf24_shadowInvalidate( void ){
+	nrf24_shadowValid = 0;
+}
+
+/*
+ * nrf24_shadowResync - Reloads the shadow copy of every cacheable register from the chip
+ *
+ * @return: NRF24_OK, error code of the first failed read otherwise
+ */
+nrf24_err_t nrf24_shadowResync( void ){
+	uint8_t reg;
+	uint8_t buffer[NRF24_ADDR_MAX_WIDTH];
+	nrf24_err_t err;
+
+	for( reg = 0; reg < NRF24_SHADOW_REG_COUNT; reg++ ){
+		if( nrf24_isCacheable(reg) ){
+			// readReg refreshes the shadow copy
+			err = nrf24_readReg( reg, buffer, (nrf24_shadowAddrIndex(reg) < NRF24_SHADOW_ADDR_COUNT) ? NRF24_ADDR_MAX_WIDTH : 1 );
+			if( err != NRF24_OK ){
+				return err;
+			}
+		}
+	}
+
+	return NRF24_OK;
+}
 
+/*
+ * nrf24_shadowVerify - Compares every valid shadow value against the chip without modifying either
+ * A brown-out resets NRF24 to its defaults while the shadow copy keeps the intended configuration.
+ *
+ * *uint8_t @mismatches: # of registers whose chip value differs from the shadow copy
+ * 
+ * @return: NRF24_OK, error code of the first failed read otherwise
+ */
+nrf24_err_t nrf24_shadowVerify( uint8_t* mismatches ){
+	uint8_t reg, index, size;
+	uint8_t buffer[NRF24_ADDR_MAX_WIDTH];
+	nrf24_err_t err;
 
-/* --- Local functions --- */
-static void custom_assert( int result );
-static void centralized_errorHandler();
-static void CE_Disable( void );
-static void CE_Enable( void );
-static void NSS_Select( void );
-static void NSS_Deselect( void );
-
-/*
-* [WARNING] - this function might utilize serial output!
-* NRF24_assert - NRF24, STM32F407G-Disc1 specific assert functions that checks if an expression is correct
-* In case, the expression is False, NRF24_centralized_errorHandler is invoked.
-*
-* @return: void
-*/
-#ifdef NRF24_USE_ASSERTS 
-static void custom_assert( int result ){
-	if(result == FALSE){
-		// TODO: send line number of the code or some other info to be printed out
-		centralized_errorHandler();	
+	*mismatches = 0;
+
+	for( reg = 0; reg < NRF24_SHADOW_REG_COUNT; reg++ ){
+		if( !nrf24_isCacheable(reg) || ((nrf24_shadowValid >> reg) & 0b1u) == 0 ){
+			continue;
+		}
+
+		index = nrf24_shadowAddrIndex(reg);
+		size = (index < NRF24_SHADOW_ADDR_COUNT) ? nrf24_shadowAddrLen[index] : 1;
+
+		// Raw transfer, readReg would overwrite the shadow copy
+		err = nrf24_transfer( R_REGISTER | reg, NULL, buffer, size );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		if( index < NRF24_SHADOW_ADDR_COUNT ){
+			*mismatches += (memcmp( buffer, nrf24_shadowAddr[index], size ) != 0);
+		} else {
+			*mismatches += (buffer[0] != nrf24_shadow[reg]);
+		}
 	}
+
+	return NRF24_OK;
 }
-#endif
 
 /*
-* [WARNING] - this function utilizes serial output!
-* NRF24_centralized_errorHandler - Centralized error handler that is invoked by the NRF24_assert function
-* Default beahvior: system outputs error-specific information and flashes the red LED.
-*  
-* @return: void 
-*/
-static void centralized_errorHandler(){
-	// TODO: to be implemented
-}
+ * nrf24_shadowRestore - Writes every valid shadow value back to the chip (e.g. after a brown-out)
+ * CE is dropped for the duration so the chip is not transmitting/receiving half-configured.
+ * On a failed write CE stays low.
+ *
+ * @return: NRF24_OK, error code of the first failed write otherwise
+ */
+nrf24_err_t nrf24_shadowRestore( void ){
+	uint8_t reg, index;
+	uint8_t ce = CE_IsEnabled();
+	nrf24_err_t err;
 
+	CE_Disable();
 
-/*
-* Chip enable, disable functions.
-* 1 = Chip is enabled
-* 0 = Chip is disabled
-*/
-static void CE_Enable( void ){
-	HAL_GPIO_WritePin(NRF24_CE_PORT, NRF24_CE_PIN, GPIO_PIN_SET);
+	for( reg = 0; reg < NRF24_SHADOW_REG_COUNT; reg++ ){
+		if( !nrf24_isCacheable(reg) || ((nrf24_shadowValid >> reg) & 0b1u) == 0 ){
+			continue;
+		}
+
+		index = nrf24_shadowAddrIndex(reg);
+		if( index < NRF24_SHADOW_ADDR_COUNT ){
+			err = nrf24_transfer( W_REGISTER | reg, nrf24_shadowAddr[index], NULL, nrf24_shadowAddrLen[index] );
+		} else {
+			err = nrf24_transfer( W_REGISTER | reg, &nrf24_shadow[reg], NULL, 1 );
+		}
+
+		if( err != NRF24_OK ){
+			return err;
+		}
+	}
+
+	if( ce ){
+		CE_Enable();
+	}
+
+	return NRF24_OK;
 }
 
-static void CE_Disable( void ){
-	HAL_GPIO_WritePin(NRF24_CE_PORT, NRF24_CE_PIN, GPIO_PIN_RESET);
+/*
+ * nrf24_getShadowStats - Copies the shadow cache hit/miss counters
+ *
+ * nrf24_shadow_stats_t* @stats: Destination of the counters
+ * 
+ * @return: void
+ */
+void nrf24_getShadowStats( nrf24_shadow_stats_t* stats ){
+	*stats = nrf24_shadowStats;
 }
 
 /*
-* Slave select, deselect functions.
-* 0 = Slave is selected
-* 1 = Slave is deselected
-*/
-static void NSS_Select( void ){
-	HAL_GPIO_WritePin(NRF24_NSS_PORT, NRF24_NSS_PIN, GPIO_PIN_RESET);
+ * nrf24_resetShadowStats - Zeroes the shadow cache hit/miss counters
+ *
+ * @return: void
+ */
+void nrf24_resetShadowStats( void ){
+	nrf24_shadowStats.hits = 0;
+	nrf24_shadowStats.misses = 0;
 }
 
-static void NSS_Deselect( void ){
-	HAL_GPIO_WritePin(NRF24_NSS_PORT, NRF24_NSS_PIN, GPIO_PIN_SET);
+
+
+/* --- Channel scan APIs --- */
+/*
+ * nrf24_scanChannels - Builds an occupancy map of the 2.4GHz band from the RPD bit (received power > -64dBm)
+ * Sweeps all channels @samples times, so a burst of Wi-Fi traffic is spread over the sweeps instead of
+ * hitting a single channel. Each sample listens NRF24_RPD_DWELL_US with CE high, dropping CE latches RPD.
+ * One sweep takes about 126 x 200us = 25ms.
+ * The chip is put in PRX for the scan, CONFIG, RF_CH and the CE state are restored afterwards
+ * (a TX stream in progress is interrupted, queued payloads are loaded again on return).
+ * Requires nrf24_Init (cycle counter). At start-up: nrf24_Init, scan, then nrf24_Reconfigure to the
+ * channel picked by nrf24_quietestChannel.
+ *
+ * uint8_t @samples:			# of sweeps (1-255)
+ * *uint8_t @occupancy:	NRF24_CHANNEL_COUNT counters, # of sweeps each channel was busy in
+ * 
+ * @return: NRF24_OK, error code otherwise (CONFIG and RF_CH restored when possible)
+ */
+nrf24_err_t nrf24_scanChannels( uint8_t samples, uint8_t* occupancy ){
+	uint8_t config, scan_config, channel, rf_ch, rpd;
+	uint8_t ce = CE_IsEnabled();
+	uint8_t sample;
+	nrf24_err_t err, restore;
+
+	memset( occupancy, 0, NRF24_CHANNEL_COUNT );
+
+	err = nrf24_readRegCached( NRF24_REG_CONFIG, &config, 1 );
+	if( err == NRF24_OK ){
+		err = nrf24_readRegCached( NRF24_REG_RF_CH, &rf_ch, 1 );
+	}
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	/* Standby-I, then PRX */
+	CE_Disable();
+	nrf24_txStreaming = FALSE;
+	nrf24_txDeferred = FALSE;
+
+	err = nrf24_powerUp();
+	if( err == NRF24_OK ){
+		scan_config = (uint8_t)(config | (NRF24_REG_CONFIG_PRIM_RX_Val_PRX << NRF24_REG_CONFIG_PRIM_RX_Pos));
+		err = nrf24_writeRegCached( NRF24_REG_CONFIG, &scan_config, 1 );
+	}
+	if( err == NRF24_OK ){
+		err = nrf24_waitReady();
+	}
+
+	for( sample = 0; sample < samples && err == NRF24_OK; sample++ ){
+		for( channel = 0; channel < NRF24_CHANNEL_COUNT; channel++ ){
+			err = nrf24_writeReg( NRF24_REG_RF_CH, &channel, 1 );
+			if( err != NRF24_OK ){
+				break;
+			}
+
+			CE_Enable();
+			nrf24_delayUs( NRF24_RPD_DWELL_US );
+			CE_Disable();
+
+			err = nrf24_readReg( NRF24_REG_RPD, &rpd, 1 );
+			if( err != NRF24_OK ){
+				break;
+			}
+
+			occupancy[channel] += (rpd >> NRF24_REG_RPD_RPD_Pos) & 0b1u;
+		}
+	}
+
+	/* Back to the previous channel/role */
+	restore = nrf24_writeRegCached( NRF24_REG_RF_CH, &rf_ch, 1 );
+	if( restore == NRF24_OK ){
+		restore = nrf24_writeRegCached( NRF24_REG_CONFIG, &config, 1 );
+	}
+	if( err == NRF24_OK ){
+		err = restore;
+	}
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	if( ce ){
+		CE_Enable();
+		nrf24_delayUs( NRF24_RX_SETTLING_US );
+	}
+
+	if( nrf24_ringLevel( &nrf24_txRing ) != 0 ){
+		__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+	}
+
+	return NRF24_OK;
 }
 
+/*
+ * nrf24_quietestChannel - Picks the channel of @first-@last with the least activity around it
+ * A 2Mbps link occupies 2MHz and Wi-Fi spreads over ~22 channels, so each channel is scored with its
+ * neighbours: 4 x own + 2 x (+/-1) + 1 x (+/-2) hits. Ties go to the lowest channel.
+ * Channels above 83 (2483MHz) are outside the 2.4GHz ISM band in most regions, keep @last within it.
+ *
+ * const uint8_t* @occupancy:	map from nrf24_scanChannels
+ * uint8_t @first:						lowest channel allowed
+ * uint8_t @last:							highest channel allowed (up to 125)
+ * 
+ * @return: channel number, NRF24_CHANNEL_COUNT if the range is invalid
+ */
+uint8_t nrf24_quietestChannel( const uint8_t* occupancy, uint8_t first, uint8_t last ){
+	static const uint8_t weight[5] = { 1, 2, 4, 2, 1 };
+	uint32_t score, best_score = UINT32_MAX;
+	uint8_t channel, best = first;
+	int16_t neighbour;
+	uint8_t i;
+
+	NRF24_ASSERT_RETURN( first <= last && last < NRF24_CHANNEL_COUNT, NRF24_CHANNEL_COUNT );
+
+	for( channel = first; channel <= last; channel++ ){
+		score = 0;
+		for( i = 0; i < 5; i++ ){
+			neighbour = (int16_t)channel + i - 2;
+			if( neighbour >= 0 && neighbour < NRF24_CHANNEL_COUNT ){
+				score += (uint32_t)weight[i] * occupancy[neighbour];
+			}
+		}
+
+		if( score < best_score ){
+			best_score = score;
+			best = channel;
+		}
+	}
+
+	return best;
+}
 
 
-/* --- General APIs --- */
 
+/* --- Link quality APIs --- */
 /*
- * nrf24_writeReg - Writes @size # of data bytes to the @reg NRF24 register
+ * nrf24_getLinkStats - Copies the link quality sampled by nrf24_irqHandler
  *
- * uint8_t @reg:		The 5bit register address: 000AAAAA
- * *uint8_t @data:	Data to be written to the register
- * uint8_t @size:		# of data bytes to be transmitted (size of the TX buffer)
+ * nrf24_link_stats_t* @stats: destination
  * 
  * @return: void
  */
-void nrf24_writeReg( uint8_t reg, uint8_t* data, uint8_t size ){
-	// Register. Write operation requires "001A AAAA" pattern
-	// where "A"s are the 5 bit register address
-	reg = reg | (0b1 << 5);
+void nrf24_getLinkStats( nrf24_link_stats_t* stats ){
+	uint32_t primask = __get_PRIMASK();
 
-	// Enable listening on the NRF24's end by pulling NSS pin low (SPI logic)
-	NSS_Select();
+	__disable_irq();
+	*stats = nrf24_linkStats;
+	__set_PRIMASK( primask );
+}
 
-	// Transmit register address over the SPI
-	HAL_SPI_Transmit( &NRF24_SPI_HANDLER, &reg, 1, 1000 );
+/*
+ * nrf24_resetLinkStats - Zeroes the link quality counters and moving averages
+ *
+ * @return: void
+ */
+void nrf24_resetLinkStats( void ){
+	uint32_t primask = __get_PRIMASK();
 
-	// Transmit data over the SPI
-	HAL_SPI_Transmit( &NRF24_SPI_HANDLER, data, size, 1000 );
-	
-	// Release NRF24
-	NSS_Deselect();
+	__disable_irq();
+	memset( &nrf24_linkStats, 0, sizeof(nrf24_linkStats) );
+	nrf24_linkAdaptCount = 0;
+	__set_PRIMASK( primask );
 }
 
 /*
- * nrf24_readReg - Reads @size # of data bytes from the @reg NRF24 register
+ * nrf24_setLinkAdaptation - Lets nrf24_irqHandler adapt SETUP_RETR to the link (PTX)
+ * ARC and ARD may go anywhere from NRF24_LINK_ARC_MIN/250us to 15/4000us, the data rate is
+ * never changed (the PRX would have to follow it). Off by default, nrf24_Init restores the configured values.
  *
- * uint8_t @reg:		The 5bit register address: 000AAAAA
- * *uint8_t @data:	Data to be written to the register
- * uint8_t @size:		# of data bytes to be received (size of the RX buffer)
+ * uint8_t @mode: @NRF24_LINK_ADAPT_xx
  * 
  * @return: void
  */
-void nrf24_readReg( uint8_t reg, uint8_t* buffer, uint8_t size ){
-	// Enable listening on the NRF24's end by pulling NSS pin low (SPI logic)
-	NSS_Select();
+void nrf24_setLinkAdaptation( uint8_t mode ){
+	nrf24_linkAdaptCount = 0;
+	nrf24_linkAdapt = mode;
+}
 
-	// Request data from the register
-	HAL_SPI_Transmit( &NRF24_SPI_HANDLER, &reg, 1, 1000 );
 
-	// Store the received data in the buffer
-	HAL_SPI_Receive( &NRF24_SPI_HANDLER, buffer, size, 1000);
-	
-	// Release NRF24
-	NSS_Deselect();
+
+/* --- Fault APIs --- */
+/*
+ * nrf24_getFaultCount - Returns how many times a fault was raised since the log was last cleared
+ * (the count survives resets, see nrf24_faultLog)
+ *
+ * uint8_t @code: @NRF24_FAULT_xx
+ * 
+ * @return: # of faults, 0 if @code is unknown
+ */
+uint32_t nrf24_getFaultCount( uint8_t code ){
+	NRF24_ASSERT_RETURN( code < NRF24_FAULT_COUNT, 0 );
+
+	nrf24_faultLogCheck();
+
+	return nrf24_faultLog.count[code];
 }
 
 /*
- * nrf24_sendStandaloneCmd - Sends the @cmd command to the NRF24 module
+ * nrf24_getFaults - Copies the most recent faults, newest first
+ * [WARNING] - an entry being recorded by an ISR at the same time may be copied half-written.
  *
- * uint8_t @cmd: The standalone command(no data bytes) to be sent
+ * *nrf24_fault_t @faults:	destination
+ * uint8_t @max:						# of entries @faults can hold
  * 
+ * @return: # of entries copied (up to NRF24_FAULT_LOG_SIZE)
+ */
+uint8_t nrf24_getFaults( nrf24_fault_t* faults, uint8_t max ){
+	uint32_t head;
+	uint8_t i, count;
+
+	nrf24_faultLogCheck();
+
+	head = nrf24_faultLog.head;
+	count = (head < NRF24_FAULT_LOG_SIZE) ? head : NRF24_FAULT_LOG_SIZE;
+	if( count > max ){
+		count = max;
+	}
+
+	for( i = 0; i < count; i++ ){
+		faults[i] = nrf24_faultLog.entry[(head - 1u - i) & (NRF24_FAULT_LOG_SIZE - 1u)];
+	}
+
+	return count;
+}
+
+/*
+ * nrf24_clearFaults - Clears the fault counters and the fault log
+ *
  * @return: void
  */
-void nrf24_sendStandaloneCmd( uint8_t cmd ){
-	// Enable listening on the NRF24's end by pulling NSS pin low (SPI logic)
-	NSS_Select();
+void nrf24_clearFaults( void ){
+	nrf24_faultLog.magic = 0;
+	nrf24_faultLogCheck();
+}
 
-	// Request data from the register
-	HAL_SPI_Transmit( &NRF24_SPI_HANDLER, &cmd, 1, 1000 );
 
-	// Release NRF24
-	NSS_Deselect();
+#ifdef NRF24_USE_PROFILING
+/* --- Profiling APIs --- */
+/*
+ * nrf24_getProfile - Copies the statistics of a profiled region
+ *
+ * uint8_t @region:						@NRF24_PROFILE_xx
+ * nrf24_profile_t* @profile:	destination (untouched if @region is unknown)
+ * 
+ * @return: void
+ */
+void nrf24_getProfile( uint8_t region, nrf24_profile_t* profile ){
+	uint32_t primask = __get_PRIMASK();
+
+	NRF24_ASSERT_RETURN( region < NRF24_PROFILE_COUNT, );
+
+	__disable_irq();
+	*profile = nrf24_profile[region];
+	__set_PRIMASK( primask );
+}
+
+/*
+ * nrf24_resetProfile - Clears the statistics of every profiled region
+ *
+ * @return: void
+ */
+void nrf24_resetProfile( void ){
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	memset( nrf24_profile, 0, sizeof(nrf24_profile) );
+	__set_PRIMASK( primask );
+}
+
+/*
+ * [WARNING] - this function utilizes serial output!
+ * nrf24_dumpProfile - Prints min/max/mean and the non-empty histogram buckets of every region, in cycles
+ *
+ * @return: void
+ */
+void nrf24_dumpProfile( void ){
+	nrf24_profile_t profile;
+	uint8_t region, bucket;
+
+	printf( "nrf24 profile @ %lu Hz\r\n", (unsigned long)SystemCoreClock );
+
+	for( region = 0; region < NRF24_PROFILE_COUNT; region++ ){
+		nrf24_getProfile( region, &profile );
+
+		printf( "%s: n=%lu min=%lu max=%lu mean=%lu\r\n", nrf24_profileName[region],
+			(unsigned long)profile.count, (unsigned long)profile.min, (unsigned long)profile.max,
+			(unsigned long)(profile.count ? profile.total / profile.count : 0) );
+
+		for( bucket = 0; bucket < NRF24_PROFILE_BUCKETS; bucket++ ){
+			if( profile.histogram[bucket] != 0 ){
+				printf( "  >=%lu: %lu\r\n", 1ul << bucket, (unsigned long)profile.histogram[bucket] );
+			}
+		}
+	}
 }
+#endif
 
 
 /* --- Init APIs --- */
-// TODO: implement asserts
-// TODO: apply asserts in init
-// TODO: ensure that the SPI CPOL, CPHA match NRF24l01+'s configs 
+
+/* Single-byte registers derived from nrf24_config_t, in the order they are written */
+const uint8_t nrf24_configRegAddr[NRF24_CONFIG_REG_COUNT] = {
+	NRF24_REG_CONFIG,
+	NRF24_REG_EN_AA,
+	NRF24_REG_EN_RXADDR,
+	NRF24_REG_SETUP_RETR,
+	NRF24_REG_SETUP_AW,
+	NRF24_REG_RF_CH,
+	NRF24_REG_RF_SETUP,
+	NRF24_REG_RX_PW_P0,
+	NRF24_REG_RX_PW_P1,
+	NRF24_REG_RX_PW_P2,
+	NRF24_REG_RX_PW_P3,
+	NRF24_REG_RX_PW_P4,
+	NRF24_REG_RX_PW_P5,
+	NRF24_REG_RX_ADDR_P2,
+	NRF24_REG_RX_ADDR_P3,
+	NRF24_REG_RX_ADDR_P4,
+	NRF24_REG_RX_ADDR_P5,
+	NRF24_REG_FEATURE,
+	NRF24_REG_DYNPD,
+};
+
+/* Multi-byte address registers derived from nrf24_config_t (same order as the shadow copy) */
+const uint8_t nrf24_configAddrReg[NRF24_CONFIG_ADDR_COUNT] = {
+	NRF24_REG_RX_ADDR_P0,
+	NRF24_REG_RX_ADDR_P1,
+	NRF24_REG_TX_ADDR,
+};
+
 /*
- * nrf24_Init - Initializes the NRF24l01+ module in the polling SPI manner
+ * nrf24_configToRegs - Translates @nrf24_config into the register values nrf24_Init writes
+ * Illegal settings raise NRF24_FAULT_ASSERT (the NRF24_STATIC_xx macros reject them at compile time),
+ * an address or payload width out of range also stops the translation.
  *
- * nrf24_config_t @nrf24_config: structure with the NRF24 configurations 
+ * nrf24_config_t* @nrf24_config:	structure with the NRF24 configurations
+ * nrf24_regs_t* @regs:						destination register image
  * 
- * @return: void
+ * @return: NRF24_OK, NRF24_ERR_PARAM if the address width or payload width is out of range
  */
-void nrf24_Init( nrf24_config_t* nrf24_config ){
+nrf24_err_t nrf24_configToRegs( nrf24_config_t* nrf24_config, nrf24_regs_t* regs ){
 	/* Initialize the variable that will hold the values to be written to the registers */
 	uint8_t holder;
+	uint8_t en_aa, en_rxaddr;
+	uint8_t pipe;
 
-	/* Assert if NSS is disabled(high) */
-	custom_assert( HAL_GPIO_ReadPin(NRF24_NSS_PORT, NRF24_NSS_PIN) == GPIO_PIN_SET );
+	NRF24_ASSERT_RETURN( nrf24_config->address_width != NRF24_REG_SETUP_AW_Val_ILLEGAL && nrf24_config->address_width <= NRF24_REG_SETUP_AW_Val_5BYTES, NRF24_ERR_PARAM );
+	NRF24_ASSERT( nrf24_config->rf_chl <= 125u );
+	NRF24_ASSERT( nrf24_config->arc <= 15u && nrf24_config->ard <= 15u );
+	NRF24_ASSERT( nrf24_config->dr_high <= 1u && !(nrf24_config->dr_high && nrf24_config->dr_low) );
+	NRF24_ASSERT_RETURN( nrf24_config->dpl || (nrf24_config->payload_width >= 1u && nrf24_config->payload_width <= NRF24_MAX_PAYLOAD_SIZE), NRF24_ERR_PARAM );
+	NRF24_ASSERT( !nrf24_config->ack_pay || nrf24_config->dpl );
 
-	/* Disable NRF24 before modifying its registers */
-	CE_Disable();
+	regs->used = 0;
+	regs->address_used = 0;
+	regs->address_size = nrf24_config->address_width + 2;
 
 	/* Config register */
 	holder = 0b0;
@@ -188,41 +3018,87 @@ void nrf24_Init( nrf24_config_t* nrf24_config ){
 	// Mask RX_DR
 	holder |= nrf24_config->rx_iqr << NRF24_REG_CONFIG_MASK_RX_DR_Pos;	
 	
-	// Final write to the config register
-	nrf24_writeReg(NRF24_REG_CONFIG, &holder, 1);
+	regs->value[NRF24_CONFIG_REG_CONFIG] = holder;
+	regs->used |= 0b1u << NRF24_CONFIG_REG_CONFIG;
 
 	/* RX pipes (only when the mode is RX) */
 	if( nrf24_config->mode ) {
-		// Enable the pipe #0
-		holder = (uint8_t)(NRF24_REG_EN_AA_ENAA_Px_Val_ENABLE << NRF24_REG_EN_AA_ENAA_P0_Pos);
-		nrf24_writeReg(NRF24_REG_EN_AA, &holder, 1);
+		en_aa = 0b0;
+		en_rxaddr = 0b0;
+
+		for( pipe = 0; pipe < NRF24_PIPE_COUNT; pipe++ ){
+			if( nrf24_config->pipes[pipe].enable == NRF24_REG_EN_RXADDR_ERX_Px_Val_DISABLE ){
+				continue;
+			}
 
-		// Enable ACKing for the pipe #0
-		holder = (uint8_t)(NRF24_REG_EN_RXADDR_ERX_Px_Val_ENABLE << NRF24_REG_EN_RXADDR_ERX_P0_Pos);
-		nrf24_writeReg(NRF24_REG_EN_RXADDR, &holder, 1);
+			// Enable the pipe and its ACKing
+			en_rxaddr |= NRF24_REG_EN_RXADDR_ERX_Px_Val_ENABLE << (NRF24_REG_EN_RXADDR_ERX_P0_Pos + pipe);
+			en_aa |= nrf24_config->pipes[pipe].auto_ack << (NRF24_REG_EN_AA_ENAA_P0_Pos + pipe);
+
+			// Static payload width
+			regs->value[NRF24_CONFIG_REG_RX_PW_P0 + pipe] = (uint8_t)(nrf24_config->payload_width << NRF24_REG_RX_PW_PX_LEN_Pos);
+			regs->used |= 0b1u << (NRF24_CONFIG_REG_RX_PW_P0 + pipe);
+
+			// Address: full width for the pipe #0, LSByte only for #2-#5 (pipe #1 below)
+			if( pipe == 0 ){
+				memcpy( regs->address[NRF24_CONFIG_ADDR_RX_ADDR_P0], nrf24_config->pipes[0].address, regs->address_size );
+				regs->address_used |= 0b1u << NRF24_CONFIG_ADDR_RX_ADDR_P0;
+			} else if( pipe >= 2 ){
+				regs->value[NRF24_CONFIG_REG_RX_ADDR_P2 + pipe - 2] = nrf24_config->pipes[pipe].address[0];
+				regs->used |= 0b1u << (NRF24_CONFIG_REG_RX_ADDR_P2 + pipe - 2);
+			}
+		}
+
+		// Full width for the pipe #1, also when only #2-#5 are enabled: they take their MSBytes from RX_ADDR_P1
+		if( en_rxaddr & (0b111110u << NRF24_REG_EN_RXADDR_ERX_P0_Pos) ){
+			memcpy( regs->address[NRF24_CONFIG_ADDR_RX_ADDR_P1], nrf24_config->pipes[1].address, regs->address_size );
+			regs->address_used |= 0b1u << NRF24_CONFIG_ADDR_RX_ADDR_P1;
+		}
+
+		regs->value[NRF24_CONFIG_REG_EN_AA] = en_aa;
+		regs->used |= 0b1u << NRF24_CONFIG_REG_EN_AA;
+
+		regs->value[NRF24_CONFIG_REG_EN_RXADDR] = en_rxaddr;
+		regs->used |= 0b1u << NRF24_CONFIG_REG_EN_RXADDR;
 	}
 
-	/* TX Re-transmission (only when the mode is TX) */
+	/* TX addressing (only when the mode is TX) */
 	else {
-		holder = 0b0;
+		// ACKs come back on the pipe #0 from the TX address
+		regs->value[NRF24_CONFIG_REG_EN_AA] = (uint8_t)(nrf24_config->pipes[0].auto_ack << NRF24_REG_EN_AA_ENAA_P0_Pos);
+		regs->used |= 0b1u << NRF24_CONFIG_REG_EN_AA;
+
+		regs->value[NRF24_CONFIG_REG_EN_RXADDR] = (uint8_t)(NRF24_REG_EN_RXADDR_ERX_Px_Val_ENABLE << NRF24_REG_EN_RXADDR_ERX_P0_Pos);
+		regs->used |= 0b1u << NRF24_CONFIG_REG_EN_RXADDR;
 
-		// ARC
-		holder |= nrf24_config->arc << NRF24_REG_SETUP_RETR_ARC_Pos;
+		// Static payload width of the pipe #0, used once nrf24_setRole turns it into a receiver
+		regs->value[NRF24_CONFIG_REG_RX_PW_P0] = (uint8_t)(nrf24_config->payload_width << NRF24_REG_RX_PW_PX_LEN_Pos);
+		regs->used |= 0b1u << NRF24_CONFIG_REG_RX_PW_P0;
 
-		// ARD
-		holder |= nrf24_config->ard << NRF24_REG_SETUP_RETR_ARD_Pos;
-		
-		// Final write to the SETUP_RETR register
-		nrf24_writeReg(NRF24_REG_SETUP_RETR, &holder, 1);
+		memcpy( regs->address[NRF24_CONFIG_ADDR_TX_ADDR], nrf24_config->tx_address, regs->address_size );
+		memcpy( regs->address[NRF24_CONFIG_ADDR_RX_ADDR_P0], nrf24_config->tx_address, regs->address_size );
+		regs->address_used |= (0b1u << NRF24_CONFIG_ADDR_TX_ADDR) | (0b1u << NRF24_CONFIG_ADDR_RX_ADDR_P0);
 	}
 
+	/* Re-transmission, in both modes: nrf24_setRole can turn a PRX into a PTX */
+	holder = 0b0;
+
+	// ARC
+	holder |= nrf24_config->arc << NRF24_REG_SETUP_RETR_ARC_Pos;
+
+	// ARD
+	holder |= nrf24_config->ard << NRF24_REG_SETUP_RETR_ARD_Pos;
+	
+	regs->value[NRF24_CONFIG_REG_SETUP_RETR] = holder;
+	regs->used |= 0b1u << NRF24_CONFIG_REG_SETUP_RETR;
+
 	/* Address Width */
-	holder = (uint8_t)(nrf24_config->address_width << NRF24_REG_SETUP_AW_Pos);
-	nrf24_writeReg(NRF24_REG_SETUP_AW, &holder, 1);
+	regs->value[NRF24_CONFIG_REG_SETUP_AW] = (uint8_t)(nrf24_config->address_width << NRF24_REG_SETUP_AW_Pos);
+	regs->used |= 0b1u << NRF24_CONFIG_REG_SETUP_AW;
 
 	/* RF Channel */
-	holder = (uint8_t)((nrf24_config->rf_chl) << NRF24_REG_RF_CH_RF_CH_Pos);
-	nrf24_writeReg(NRF24_REG_RF_CH, &holder, 1);
+	regs->value[NRF24_CONFIG_REG_RF_CH] = (uint8_t)((nrf24_config->rf_chl) << NRF24_REG_RF_CH_RF_CH_Pos);
+	regs->used |= 0b1u << NRF24_CONFIG_REG_RF_CH;
 
 	/* RF Setup */
 	holder = 0b0;
@@ -242,9 +3118,204 @@ void nrf24_Init( nrf24_config_t* nrf24_config ){
 	// Count Wave
 	holder |= nrf24_config->count_wave << NRF24_REG_RF_SETUP_CONT_WAVE_Pos;
 
-	// Final write to the RF_SETUP function
-	nrf24_writeReg(NRF24_REG_RF_SETUP, &holder, 1);
+	regs->value[NRF24_CONFIG_REG_RF_SETUP] = holder;
+	regs->used |= 0b1u << NRF24_CONFIG_REG_RF_SETUP;
+
+	/* Feature */
+	holder = 0b0;
+
+	// Per-packet NO_ACK (W_TX_PAYLOAD_NOACK)
+	holder |= nrf24_config->en_dyn_ack << NRF24_REG_FEATURE_EN_DYN_ACK_Pos;
+
+	// Payloads carried in the ACKs
+	holder |= nrf24_config->ack_pay << NRF24_REG_FEATURE_EN_ACK_PAY_Pos;
+
+	// Dynamic payload length
+	holder |= nrf24_config->dpl << NRF24_REG_FEATURE_EN_DPL_Pos;
+
+	regs->value[NRF24_CONFIG_REG_FEATURE] = holder;
+	regs->used |= 0b1u << NRF24_CONFIG_REG_FEATURE;
+
+	/* Dynamic payload length per pipe, only on pipes with auto-ack (the pipe #0 in TX mode) */
+	regs->value[NRF24_CONFIG_REG_DYNPD] = nrf24_config->dpl ? regs->value[NRF24_CONFIG_REG_EN_AA] : 0b0;
+	regs->used |= 0b1u << NRF24_CONFIG_REG_DYNPD;
+
+	return NRF24_OK;
+}
+
+// TODO: ensure that the SPI CPOL, CPHA match NRF24l01+'s configs 
+/*
+ * nrf24_Init - Initializes the NRF24l01+ module in the polling SPI manner
+ *
+ * nrf24_config_t @nrf24_config: structure with the NRF24 configurations 
+ * 
+ * @return: NRF24_OK, NRF24_ERR_PARAM if the address/payload width is out of range (nothing written),
+ * error code otherwise (CE is left low)
+ */
+nrf24_err_t nrf24_Init( nrf24_config_t* nrf24_config ){
+	nrf24_regs_t regs;
+	nrf24_err_t err;
+
+	err = nrf24_configToRegs( nrf24_config, &regs );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	return nrf24_InitRegs( &regs );
+}
+
+/*
+ * nrf24_InitRegs - Initializes the NRF24l01+ module from a register image, either derived
+ * by nrf24_Init or built at compile time with the NRF24_STATIC_xx macros (no translation at runtime).
+ * The shadow copy is invalidated first, so every register of @regs is written
+ *
+ * const nrf24_regs_t* @regs: register values to be written
+ * 
+ * @return: NRF24_OK, error code otherwise (CE is left low)
+ */
+nrf24_err_t nrf24_InitRegs( const nrf24_regs_t* regs ){
+	nrf24_batch_t batch;
+	uint8_t holder;
+	uint8_t powered_down;
+	uint8_t i;
+	nrf24_err_t err;
+
+	/* Validate the fault log left by the previous run before anything can be raised */
+	nrf24_faultLogCheck();
+
+	/* The chip may have been reset (brown-out, power cycle) since the shadow copy was filled */
+	nrf24_shadowInvalidate();
+
+	/* Assert if NSS is disabled(high) */
+	NRF24_ASSERT( HAL_GPIO_ReadPin(NRF24_NSS_PORT, NRF24_NSS_PIN) == GPIO_PIN_SET );
+
+	/* Cycle counter used for the settling delays and the SPI timeouts */
+	nrf24_timeInit();
+	nrf24_timeoutInit();
+
+	/* Disable NRF24 before modifying its registers */
+	CE_Disable();
+
+	/* CONFIG sets PWR_UP: start-up timing as in nrf24_powerUp if the chip was powered down */
+	err = nrf24_readRegCached( NRF24_REG_CONFIG, &holder, 1 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+	powered_down = ((holder >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u) == 0;
+
+	nrf24_batchInit( &batch );
+
+	/* Clear stale interrupt flags: a line already held low would never produce a falling edge */
+	holder = NRF24_STATUS_IRQ_MASK;
+	nrf24_batchWriteReg( &batch, NRF24_REG_STATUS, &holder, 1 );
+
+	/* Every register of the configuration, recorded in the shadow copy as its frame completes,
+	the batch copies the bytes so @regs is never written */
+	for( i = 0; i < NRF24_CONFIG_REG_COUNT; i++ ){
+		if( (regs->used >> i) & 0b1u ){
+			nrf24_batchWriteRegCached( &batch, nrf24_configRegAddr[i], (uint8_t*)&regs->value[i], 1 );
+		}
+	}
+
+	for( i = 0; i < NRF24_CONFIG_ADDR_COUNT; i++ ){
+		if( (regs->address_used >> i) & 0b1u ){
+			nrf24_batchWriteRegCached( &batch, nrf24_configAddrReg[i], (uint8_t*)regs->address[i], regs->address_size );
+		}
+	}
+
+	/* One bus ownership for the whole configuration */
+	err = nrf24_batchExecute( &batch );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	if( powered_down ){
+		nrf24_wakeCycles = nrf24_cycles();
+		nrf24_wakeTick = HAL_GetTick();
+		nrf24_waking = TRUE;
+	}
 
 	/* Enable the NRF24 */ 
 	CE_Enable();
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_Reconfigure - Moves NRF24 from the @old_config to the @new_config configuration
+ * by writing only the registers whose value differs between the two.
+ * PWR_UP stays set, so the chip only drops to Standby-I (CE low) while the registers change
+ * and returns to its previous CE state afterwards - no power-down, no 1.5ms start-up.
+ *
+ * nrf24_config_t* @old_config:	configuration the chip currently runs with
+ * nrf24_config_t* @new_config:	configuration to be applied
+ * *uint8_t @written:						# of registers written, 0 on error (NULL = not needed)
+ * 
+ * @return: NRF24_OK, NRF24_ERR_PARAM if an address/payload width is out of range (nothing written),
+ * error code otherwise (CE is left low, registers before the failed frame may have changed)
+ */
+nrf24_err_t nrf24_Reconfigure( nrf24_config_t* old_config, nrf24_config_t* new_config, uint8_t* written ){
+	nrf24_regs_t old_regs, new_regs;
+	nrf24_batch_t batch;
+	uint8_t i, ce;
+	nrf24_err_t err;
+
+	if( written != NULL ){
+		*written = 0;
+	}
+
+	if( nrf24_configToRegs( old_config, &old_regs ) != NRF24_OK || nrf24_configToRegs( new_config, &new_regs ) != NRF24_OK ){
+		return NRF24_ERR_PARAM;
+	}
+	nrf24_batchInit( &batch );
+
+	for( i = 0; i < NRF24_CONFIG_REG_COUNT; i++ ){
+		// Not part of the new configuration
+		if( ((new_regs.used >> i) & 0b1u) == 0 ){
+			continue;
+		}
+
+		// Unchanged and already written by the old configuration
+		if( ((old_regs.used >> i) & 0b1u) && old_regs.value[i] == new_regs.value[i] ){
+			continue;
+		}
+
+		nrf24_batchWriteReg( &batch, nrf24_configRegAddr[i], &new_regs.value[i], 1 );
+	}
+
+	for( i = 0; i < NRF24_CONFIG_ADDR_COUNT; i++ ){
+		if( ((new_regs.address_used >> i) & 0b1u) == 0 ){
+			continue;
+		}
+
+		if( ((old_regs.address_used >> i) & 0b1u) && old_regs.address_size == new_regs.address_size
+		    && memcmp( old_regs.address[i], new_regs.address[i], new_regs.address_size ) == 0 ){
+			continue;
+		}
+
+		nrf24_batchWriteReg( &batch, nrf24_configAddrReg[i], new_regs.address[i], new_regs.address_size );
+	}
+
+	if( batch.count == 0 ){
+		return NRF24_OK;
+	}
+
+	// Standby-I while the registers change
+	ce = CE_IsEnabled();
+	CE_Disable();
+
+	err = nrf24_batchExecute( &batch );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	if( ce ){
+		CE_Enable();
+	}
+
+	if( written != NULL ){
+		*written = batch.count;
+	}
+
+	return NRF24_OK;
 }
@@ -0,0 +1,781 @@
+/*
+ * Benchmark of the NRF24L01 library
+ * Board: STM32F407G-Disc1
+ */
+
+
+/* Header file */
+#include "../Inc/nrf24l01p_bench.h"
+
+#ifdef NRF24_USE_BENCHMARK
+
+#include <stdio.h>
+#include <string.h>
+
+
+/* --- Benchmark state --- */
+// Written by the event callbacks (IRQ context), read by the benchmark loop
+static volatile uint32_t nrf24_benchAcked;
+static volatile uint32_t nrf24_benchLost;
+static volatile uint32_t nrf24_benchDoneCycles;
+static volatile uint32_t nrf24_benchAckReplies;
+static volatile uint32_t nrf24_benchAckCycles;
+static volatile uint32_t nrf24_benchRoleReplies;
+static volatile uint32_t nrf24_benchRoleCycles;
+static volatile uint8_t nrf24_benchSeq;             // sequence # of the request waiting for its reply
+
+static uint32_t nrf24_benchSamples[NRF24_BENCH_MAX_SAMPLES];
+
+static const char* const nrf24_benchRateName[NRF24_BENCH_DR_COUNT] = {
+	"250k",
+	"1M",
+	"2M",
+};
+
+// Indexed by @NRF24_SPI_TRANSPORT_xx
+static const char* const nrf24_benchTransportName[] = {
+	"polling",
+	"dma",
+	"register",
+};
+
+
+/* --- Local functions --- */
+
+/*
+ * nrf24_benchTxDone, nrf24_benchMaxRt - Event callbacks installed for the duration of a run
+ */
+static void nrf24_benchTxDone( void ){
+	nrf24_benchDoneCycles = DWT->CYCCNT;
+	nrf24_benchAcked++;
+}
+
+static void nrf24_benchMaxRt( void ){
+	nrf24_benchDoneCycles = DWT->CYCCNT;
+	nrf24_benchLost++;
+}
+
+/*
+ * nrf24_benchRxReady - Event callback: time stamps the answers of nrf24_benchResponder, drops
+ * everything else (ACK payloads of a passive peer are not part of the measurement)
+ */
+static void nrf24_benchRxReady( uint8_t pipe ){
+	uint8_t buffer[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size;
+
+	while( nrf24_receiveFromPipe( pipe, buffer, &size ) == NRF24_OK ){
+		if( pipe != 0 || size < NRF24_BENCH_REQUEST_SIZE ){
+			continue;
+		}
+
+		// Loaded before the request arrived, it cannot carry the request's sequence #
+		if( buffer[0] == NRF24_BENCH_MSG_ACK ){
+			nrf24_benchAckCycles = DWT->CYCCNT;
+			nrf24_benchAckReplies++;
+		} else if( buffer[0] == NRF24_BENCH_MSG_REPLY && buffer[1] == nrf24_benchSeq ){
+			nrf24_benchRoleCycles = DWT->CYCCNT;
+			nrf24_benchRoleReplies++;
+		}
+	}
+}
+
+/*
+ * nrf24_benchCyclesToUs - Converts DWT cycles to microseconds
+ *
+ * uint32_t @cycles: # of cycles
+ *
+ * @return: # of us
+ */
+static uint32_t nrf24_benchCyclesToUs( uint32_t cycles ){
+	return (uint32_t)(((uint64_t)cycles * 1000000u) / SystemCoreClock);
+}
+
+/*
+ * nrf24_benchFlushLost - Drops the TX FIFO after a MAX_RT (the lost payload would block it)
+ * and lets the IRQ handler reload it from the TX ring
+ *
+ * *uint32_t @seen: # of MAX_RT already handled, updated
+ *
+ * @return: void
+ */
+static void nrf24_benchFlushLost( uint32_t* seen ){
+	if( nrf24_benchLost == *seen ){
+		return;
+	}
+
+	*seen = nrf24_benchLost;
+	nrf24_flushTx();
+	__HAL_GPIO_EXTI_GENERATE_SWIT( NRF24_IRQ_PIN );
+}
+
+/*
+ * nrf24_benchDrain - Waits until every queued payload left: TX ring and FIFO empty, last IRQ serviced
+ *
+ * *uint32_t @seen: # of MAX_RT already handled, updated
+ *
+ * @return: TRUE if drained, FALSE if no TX event for NRF24_BENCH_PACKET_TIMEOUT_MS
+ */
+static uint8_t nrf24_benchDrain( uint32_t* seen ){
+	uint32_t start = HAL_GetTick();
+	uint32_t events = nrf24_benchAcked + nrf24_benchLost;
+	uint8_t fifo_status = 0;
+
+	for( ;; ){
+		nrf24_benchFlushLost( seen );
+
+		if( nrf24_txPending() == 0 && HAL_GPIO_ReadPin( NRF24_IRQ_PORT, NRF24_IRQ_PIN ) == GPIO_PIN_SET
+			&& nrf24_readReg( NRF24_REG_FIFO_STATUS, &fifo_status, 1 ) == NRF24_OK
+			&& ((fifo_status >> NRF24_REG_FIFO_STATUS_TX_EMPTY_Pos) & 0b1u) ){
+			return TRUE;
+		}
+
+		// Timeout restarts on every TX event
+		if( nrf24_benchAcked + nrf24_benchLost != events ){
+			events = nrf24_benchAcked + nrf24_benchLost;
+			start = HAL_GetTick();
+		} else if( (HAL_GetTick() - start) > NRF24_BENCH_PACKET_TIMEOUT_MS ){
+			return FALSE;
+		}
+	}
+}
+
+/*
+ * nrf24_benchConfigRate - Data rate of a configuration
+ *
+ * nrf24_config_t* @config: configuration
+ *
+ * @return: @NRF24_BENCH_DR_xx
+ */
+static uint8_t nrf24_benchConfigRate( nrf24_config_t* config ){
+	if( config->dr_low == NRF24_REG_RF_SETUP_RF_DR_LOW_Val_SET ){
+		return NRF24_BENCH_DR_250KBPS;
+	}
+
+	return config->dr_high ? NRF24_BENCH_DR_2MBPS : NRF24_BENCH_DR_1MBPS;
+}
+
+/*
+ * nrf24_benchPercentile - Picks the @percent percentile of sorted samples
+ *
+ * uint32_t @count:		# of samples
+ * uint8_t @percent:	0-100
+ *
+ * @return: sample value
+ */
+static uint32_t nrf24_benchPercentile( uint32_t count, uint8_t percent ){
+	if( count == 0 ){
+		return 0;
+	}
+
+	return nrf24_benchSamples[((count - 1u) * percent) / 100u];
+}
+
+/*
+ * nrf24_benchSort - Insertion sort of the round-trip samples (at most NRF24_BENCH_MAX_SAMPLES)
+ *
+ * uint32_t @count: # of samples
+ *
+ * @return: void
+ */
+static void nrf24_benchSort( uint32_t count ){
+	uint32_t i, j, value;
+
+	for( i = 1; i < count; i++ ){
+		value = nrf24_benchSamples[i];
+		for( j = i; j > 0 && nrf24_benchSamples[j - 1] > value; j-- ){
+			nrf24_benchSamples[j] = nrf24_benchSamples[j - 1];
+		}
+		nrf24_benchSamples[j] = value;
+	}
+}
+
+
+
+/* --- Benchmark APIs --- */
+
+/*
+ * nrf24_benchCommands - Times one-byte register writes and reads through the compiled SPI transport,
+ * and the NSS edges every frame starts and ends with
+ * RF_CH is read and written back with its own value NRF24_BENCH_COMMANDS times, the configuration
+ * is left as it was. Resets the profile statistics. The NSS pulses carry no clock, the chip ignores them;
+ * interrupts are masked meanwhile so no frame can start in between.
+ *
+ * nrf24_bench_cmd_result_t* @result: measurements
+ *
+ * @return: NRF24_OK, NRF24_ERR_BUSY if a frame is on the bus, driver error otherwise
+ */
+nrf24_err_t nrf24_benchCommands( nrf24_bench_cmd_result_t* result ){
+	uint8_t value;
+	uint32_t i, t0, primask;
+	nrf24_err_t err;
+#ifdef NRF24_USE_PROFILING
+	nrf24_profile_t profile;
+#endif
+
+	memset( result, 0, sizeof(*result) );
+	result->transport = NRF24_SPI_TRANSPORT;
+
+	err = nrf24_readReg( NRF24_REG_RF_CH, &value, 1 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+#ifdef NRF24_USE_PROFILING
+	nrf24_resetProfile();
+#endif
+	for( i = 0; i < NRF24_BENCH_COMMANDS; i++ ){
+		err = nrf24_writeReg( NRF24_REG_RF_CH, &value, 1 );
+		if( err == NRF24_OK ){
+			err = nrf24_readReg( NRF24_REG_RF_CH, &value, 1 );
+		}
+		if( err != NRF24_OK ){
+			return err;
+		}
+	}
+
+#ifdef NRF24_USE_PROFILING
+	nrf24_getProfile( NRF24_PROFILE_WRITE_REG, &profile );
+	result->write_reg_min = profile.min;
+	result->write_reg_mean = (uint32_t)(profile.total / profile.count);
+
+	nrf24_getProfile( NRF24_PROFILE_READ_REG, &profile );
+	result->read_reg_min = profile.min;
+	result->read_reg_mean = (uint32_t)(profile.total / profile.count);
+#endif
+
+	/* NSS select/deselect: single BSRR stores (the driver's NSS_Select/NSS_Deselect) vs HAL_GPIO_WritePin */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if( nrf24_isBusy() ){
+		__set_PRIMASK( primask );
+		return NRF24_ERR_BUSY;
+	}
+
+	t0 = DWT->CYCCNT;
+	for( i = 0; i < NRF24_BENCH_COMMANDS; i++ ){
+		NRF24_NSS_PORT->BSRR = NRF24_NSS_BSRR_RESET;
+		NRF24_NSS_PORT->BSRR = NRF24_NSS_BSRR_SET;
+	}
+	result->nss_bsrr_cycles = (DWT->CYCCNT - t0) / NRF24_BENCH_COMMANDS;
+
+	t0 = DWT->CYCCNT;
+	for( i = 0; i < NRF24_BENCH_COMMANDS; i++ ){
+		HAL_GPIO_WritePin( NRF24_NSS_PORT, NRF24_NSS_PIN, GPIO_PIN_RESET );
+		HAL_GPIO_WritePin( NRF24_NSS_PORT, NRF24_NSS_PIN, GPIO_PIN_SET );
+	}
+	result->nss_hal_cycles = (DWT->CYCCNT - t0) / NRF24_BENCH_COMMANDS;
+
+	__set_PRIMASK( primask );
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_benchPrintCommands - Prints the result of nrf24_benchCommands as a CSV header and line
+ *
+ * nrf24_bench_cmd_result_t* @result: measurements
+ *
+ * @return: void
+ */
+void nrf24_benchPrintCommands( nrf24_bench_cmd_result_t* result ){
+	printf( "transport,write_reg_min,write_reg_mean,read_reg_min,read_reg_mean,nss_bsrr_cycles,nss_hal_cycles\r\n" );
+	printf( "%s,%lu,%lu,%lu,%lu,%lu,%lu\r\n", nrf24_benchTransportName[result->transport],
+		(unsigned long)result->write_reg_min, (unsigned long)result->write_reg_mean,
+		(unsigned long)result->read_reg_min, (unsigned long)result->read_reg_mean,
+		(unsigned long)result->nss_bsrr_cycles, (unsigned long)result->nss_hal_cycles );
+}
+
+/*
+ * nrf24_benchRequests - Measures the round trip of a request and its answer, both ways: the answer
+ * comes back in the ACK payload (one air exchange), or the peer sends it after both ends switched roles
+ * [WARNING] - takes over the event callbacks (re-register the application's ones afterwards) and
+ * reinitializes NRF24 as PTX with @config. The peer runs nrf24_benchResponder with the same @config.
+ *
+ * nrf24_config_t* @config:						configuration (auto-ack on pipe #0, dpl and ack_pay)
+ * uint32_t @requests:								# of requests per answer type (at most NRF24_BENCH_MAX_SAMPLES)
+ * nrf24_bench_req_result_t* @result:	measurements
+ *
+ * @return: NRF24_OK, NRF24_ERR_STATE without dpl or ack_pay, NRF24_ERR_TIMEOUT if a request never completed,
+ * driver error otherwise
+ */
+nrf24_err_t nrf24_benchRequests( nrf24_config_t* config, uint32_t requests, nrf24_bench_req_result_t* result ){
+	nrf24_config_t bench_config = *config;
+	nrf24_event_callbacks_t callbacks = { nrf24_benchRxReady, nrf24_benchTxDone, nrf24_benchMaxRt };
+	uint8_t request[NRF24_BENCH_REQUEST_SIZE];
+	uint32_t i, start, wait, acked, replies, samples, seen;
+	nrf24_err_t err;
+
+	memset( result, 0, sizeof(*result) );
+	result->data_rate = nrf24_benchConfigRate( config );
+
+	if( !config->dpl || !config->ack_pay ){
+		return NRF24_ERR_STATE;
+	}
+
+	// The first request would include the Tpd2stby start-up
+	bench_config.mode = NRF24_REG_CONFIG_PRIM_RX_Val_PTX;
+	err = nrf24_Init( &bench_config );
+	if( err == NRF24_OK ){
+		err = nrf24_waitReady();
+	}
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	nrf24_registerCallbacks( &callbacks );
+	nrf24_benchAcked = 0;
+	nrf24_benchLost = 0;
+	nrf24_benchAckReplies = 0;
+	nrf24_benchRoleReplies = 0;
+	seen = 0;
+	result->requests = (requests < NRF24_BENCH_MAX_SAMPLES) ? requests : NRF24_BENCH_MAX_SAMPLES;
+
+	/* ACK payload: nrf24_transmit to the answer in the pipe #0 ring (it arrives before TX_DS) */
+	samples = 0;
+	request[0] = NRF24_BENCH_MSG_ACK;
+	for( i = 0; i < result->requests; i++ ){
+		request[1] = (uint8_t)i;
+		replies = nrf24_benchAckReplies;
+
+		start = DWT->CYCCNT;
+		err = nrf24_transmit( request, NRF24_BENCH_REQUEST_SIZE );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		if( !nrf24_benchDrain( &seen ) ){
+			return NRF24_ERR_TIMEOUT;
+		}
+
+		if( nrf24_benchAckReplies != replies ){
+			nrf24_benchSamples[samples++] = nrf24_benchCyclesToUs( nrf24_benchAckCycles - start );
+		}
+	}
+
+	result->ack_replies = samples;
+	nrf24_benchSort( samples );
+	result->ack_rtt_p50_us = nrf24_benchPercentile( samples, 50 );
+	result->ack_rtt_max_us = nrf24_benchPercentile( samples, 100 );
+
+	/* Role switch: nrf24_transmit, PRX once the request is ACKed, to the reply in the pipe #0 ring */
+	samples = 0;
+	request[0] = NRF24_BENCH_MSG_REPLY;
+	for( i = 0; i < result->requests; i++ ){
+		request[1] = (uint8_t)i;
+		nrf24_benchSeq = (uint8_t)i;
+		acked = nrf24_benchAcked;
+		replies = nrf24_benchRoleReplies;
+
+		start = DWT->CYCCNT;
+		err = nrf24_transmit( request, NRF24_BENCH_REQUEST_SIZE );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		if( !nrf24_benchDrain( &seen ) ){
+			return NRF24_ERR_TIMEOUT;
+		}
+
+		// Lost request: the peer does not know about it
+		if( nrf24_benchAcked == acked ){
+			continue;
+		}
+
+		err = nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PRX, &bench_config );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		wait = HAL_GetTick();
+		while( nrf24_benchRoleReplies == replies && (HAL_GetTick() - wait) <= NRF24_BENCH_PACKET_TIMEOUT_MS );
+
+		if( nrf24_benchRoleReplies != replies ){
+			nrf24_benchSamples[samples++] = nrf24_benchCyclesToUs( nrf24_benchRoleCycles - start );
+		}
+
+		err = nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PTX, &bench_config );
+		if( err != NRF24_OK ){
+			return err;
+		}
+	}
+
+	result->role_replies = samples;
+	nrf24_benchSort( samples );
+	result->role_rtt_p50_us = nrf24_benchPercentile( samples, 50 );
+	result->role_rtt_max_us = nrf24_benchPercentile( samples, 100 );
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_benchPrintRequests - Prints the result of nrf24_benchRequests as a CSV header and line
+ *
+ * nrf24_bench_req_result_t* @result: measurements
+ *
+ * @return: void
+ */
+void nrf24_benchPrintRequests( nrf24_bench_req_result_t* result ){
+	printf( "rate,requests,ack_replies,ack_rtt_p50_us,ack_rtt_max_us,role_replies,role_rtt_p50_us,role_rtt_max_us\r\n" );
+	printf( "%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n", nrf24_benchRateName[result->data_rate],
+		(unsigned long)result->requests,
+		(unsigned long)result->ack_replies, (unsigned long)result->ack_rtt_p50_us, (unsigned long)result->ack_rtt_max_us,
+		(unsigned long)result->role_replies, (unsigned long)result->role_rtt_p50_us, (unsigned long)result->role_rtt_max_us );
+}
+
+/*
+ * nrf24_benchResponder - Peer side of nrf24_benchRequests, runs on the other board as PRX: an answer
+ * is kept preloaded as ACK payload, a NRF24_BENCH_MSG_REPLY request is answered as PTX then back to PRX.
+ * It listens on @config's TX address and replies to its pipe #0 address, both boards use the same @config.
+ * Other payloads are dropped, so it also serves as the peer of nrf24_benchSweep.
+ * [WARNING] - takes over the event callbacks and reinitializes NRF24 as PRX.
+ *
+ * nrf24_config_t* @config:	configuration of the requesting board (dpl and ack_pay)
+ * uint32_t @requests:			# of requests answered before returning
+ *
+ * @return: NRF24_OK, NRF24_ERR_STATE without dpl or ack_pay, driver error otherwise
+ */
+nrf24_err_t nrf24_benchResponder( nrf24_config_t* config, uint32_t requests ){
+	nrf24_config_t responder_config = *config;
+	nrf24_event_callbacks_t callbacks = { NULL, nrf24_benchTxDone, nrf24_benchMaxRt };
+	uint8_t request[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t answer[NRF24_BENCH_REPLY_SIZE];
+	uint8_t size, fifo_status;
+	uint32_t answered, events, start;
+	nrf24_err_t err;
+
+	if( !config->dpl || !config->ack_pay ){
+		return NRF24_ERR_STATE;
+	}
+
+	responder_config.mode = NRF24_REG_CONFIG_PRIM_RX_Val_PRX;
+	memcpy( responder_config.pipes[0].address, config->tx_address, NRF24_ADDR_MAX_WIDTH );
+	memcpy( responder_config.tx_address, config->pipes[0].address, NRF24_ADDR_MAX_WIDTH );
+
+	err = nrf24_Init( &responder_config );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	nrf24_registerCallbacks( &callbacks );
+	nrf24_benchAcked = 0;
+	nrf24_benchLost = 0;
+	memset( answer, 0, sizeof(answer) );
+
+	for( answered = 0; answered < requests; ){
+		// Every packet received on pipe #0 takes the preloaded answer along with its ACK
+		err = nrf24_readReg( NRF24_REG_FIFO_STATUS, &fifo_status, 1 );
+		if( err == NRF24_OK && ((fifo_status >> NRF24_REG_FIFO_STATUS_TX_EMPTY_Pos) & 0b1u) ){
+			answer[0] = NRF24_BENCH_MSG_ACK;
+			answer[1] = (uint8_t)answered;
+			err = nrf24_writeAckPayload( 0, answer, NRF24_BENCH_REPLY_SIZE );
+		}
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		if( nrf24_receiveFromPipe( 0, request, &size ) != NRF24_OK || size < NRF24_BENCH_REQUEST_SIZE ){
+			continue;
+		}
+
+		if( request[0] == NRF24_BENCH_MSG_ACK ){
+			answered++;
+			continue;
+		}
+		if( request[0] != NRF24_BENCH_MSG_REPLY ){
+			continue;
+		}
+
+		// In PTX a preloaded ACK payload would leave as a packet of its own
+		err = nrf24_flushTx();
+		if( err == NRF24_OK ){
+			err = nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PTX, &responder_config );
+		}
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		answer[0] = NRF24_BENCH_MSG_REPLY;
+		answer[1] = request[1];
+		events = nrf24_benchAcked + nrf24_benchLost;
+		err = nrf24_transmit( answer, NRF24_BENCH_REPLY_SIZE );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		start = HAL_GetTick();
+		while( nrf24_benchAcked + nrf24_benchLost == events && (HAL_GetTick() - start) <= NRF24_BENCH_PACKET_TIMEOUT_MS );
+
+		// A lost reply would stay in the TX FIFO
+		err = nrf24_flushTx();
+		if( err == NRF24_OK ){
+			err = nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PRX, &responder_config );
+		}
+		if( err != NRF24_OK ){
+			return err;
+		}
+		answered++;
+	}
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_benchRun - Measures throughput and round-trip latency for one data rate and payload size
+ * [WARNING] - takes over the event callbacks (re-register the application's ones afterwards) and
+ * reinitializes NRF24 as PTX with @config's channel/addresses at the @data_rate.
+ * The peer has to listen at the same @data_rate, nothing tells it about a different one.
+ *
+ * nrf24_config_t* @config:				base configuration (auto-ack on pipe #0, dpl or payload_width = @size)
+ * uint8_t @data_rate:						@NRF24_BENCH_DR_xx, the peer's
+ * uint8_t @size:									payload size (1-32)
+ * uint32_t @packets:							# of payloads per phase
+ * nrf24_bench_result_t* @result:	measurements
+ *
+ * @return: NRF24_OK, NRF24_ERR_TIMEOUT if a payload never completed,
+ * NRF24_ERR_STATE if @size does not fit a static payload width, driver error otherwise
+ */
+nrf24_err_t nrf24_benchRun( nrf24_config_t* config, uint8_t data_rate, uint8_t size, uint32_t packets, nrf24_bench_result_t* result ){
+	nrf24_config_t bench_config = *config;
+	nrf24_regs_t regs;
+	nrf24_event_callbacks_t callbacks = { nrf24_benchRxReady, nrf24_benchTxDone, nrf24_benchMaxRt };
+	uint8_t payload[NRF24_MAX_PAYLOAD_SIZE];
+	uint32_t i, t0, cycles, start, submit, seen, acked, samples, limit, to_prx, to_ptx;
+	nrf24_err_t err;
+#ifdef NRF24_USE_PROFILING
+	nrf24_profile_t spi, irq;
+#endif
+
+	memset( result, 0, sizeof(*result) );
+	result->data_rate = data_rate;
+	result->size = size;
+
+	// Without dpl the peer drops every payload that is not payload_width long
+	if( !config->dpl && size != config->payload_width ){
+		return NRF24_ERR_STATE;
+	}
+
+	bench_config.mode = NRF24_REG_CONFIG_PRIM_RX_Val_PTX;
+	bench_config.dr_high = (data_rate == NRF24_BENCH_DR_2MBPS) ? 0b1u : 0b0u;
+	bench_config.dr_low = (data_rate == NRF24_BENCH_DR_250KBPS) ? NRF24_REG_RF_SETUP_RF_DR_LOW_Val_SET : NRF24_REG_RF_SETUP_RF_DR_LOW_Val_RESET;
+
+	/* Start-up: the batched register writes, then the same image one nrf24_writeReg at a time */
+	err = nrf24_configToRegs( &bench_config, &regs );
+	if( err != NRF24_OK ){
+		return err;
+	}
+
+	// A warm shadow copy would skip the unchanged registers
+	nrf24_shadowInvalidate();
+#ifdef NRF24_USE_PROFILING
+	nrf24_resetProfile();
+#endif
+	t0 = DWT->CYCCNT;
+	err = nrf24_InitRegs( &regs );
+	result->init_us = nrf24_benchCyclesToUs( DWT->CYCCNT - t0 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+#ifdef NRF24_USE_PROFILING
+	nrf24_getProfile( NRF24_PROFILE_SPI_FRAME, &spi );
+	result->init_frames = spi.count;
+	nrf24_resetProfile();
+#endif
+
+	// Same values as just written: the chip's state does not change
+	t0 = DWT->CYCCNT;
+	for( i = 0; i < NRF24_CONFIG_REG_COUNT && err == NRF24_OK; i++ ){
+		if( (regs.used >> i) & 0b1u ){
+			err = nrf24_writeReg( nrf24_configRegAddr[i], &regs.value[i], 1 );
+		}
+	}
+	for( i = 0; i < NRF24_CONFIG_ADDR_COUNT && err == NRF24_OK; i++ ){
+		if( (regs.address_used >> i) & 0b1u ){
+			err = nrf24_writeReg( nrf24_configAddrReg[i], regs.address[i], regs.address_size );
+		}
+	}
+	result->init_reg_us = nrf24_benchCyclesToUs( DWT->CYCCNT - t0 );
+	if( err != NRF24_OK ){
+		return err;
+	}
+#ifdef NRF24_USE_PROFILING
+	nrf24_getProfile( NRF24_PROFILE_SPI_FRAME, &spi );
+	result->init_reg_frames = spi.count;
+#endif
+
+	nrf24_registerCallbacks( &callbacks );
+	nrf24_benchAcked = 0;
+	nrf24_benchLost = 0;
+	seen = 0;
+
+	/* Throughput: keep the TX ring topped up, the IRQ handler streams it into the FIFO */
+	submit = 0;
+#ifdef NRF24_USE_PROFILING
+	nrf24_resetProfile();
+#endif
+	start = DWT->CYCCNT;
+	for( i = 0; i < packets; i++ ){
+		memset( payload, (uint8_t)(i & 0x7Fu), size );
+
+		// Only the call that queued the payload counts, not the retries on a full ring
+		do {
+			nrf24_benchFlushLost( &seen );
+
+			t0 = DWT->CYCCNT;
+			err = nrf24_transmit( payload, size );
+			cycles = DWT->CYCCNT - t0;
+		} while( err == NRF24_ERR_FULL );
+
+		if( err != NRF24_OK ){
+			return err;
+		}
+		submit += cycles;
+		result->sent++;
+	}
+
+	if( !nrf24_benchDrain( &seen ) ){
+		return NRF24_ERR_TIMEOUT;
+	}
+
+	// A flush after MAX_RT also drops the payloads queued behind the lost one
+	result->elapsed_us = nrf24_benchCyclesToUs( nrf24_benchDoneCycles - start );
+	result->acked = nrf24_benchAcked;
+	result->lost = result->sent - result->acked;
+	result->submit_cycles = submit / packets;
+	if( result->elapsed_us > 0 ){
+		result->pps = (uint32_t)(((uint64_t)result->acked * 1000000u) / result->elapsed_us);
+		result->goodput_bps = result->pps * size * 8u;
+	}
+#ifdef NRF24_USE_PROFILING
+	nrf24_getProfile( NRF24_PROFILE_SPI_FRAME, &spi );
+	if( nrf24_benchDoneCycles != start ){
+		result->spi_load_permille = (uint32_t)((spi.total * 1000u) / (nrf24_benchDoneCycles - start));
+	}
+
+	// Drain/refill work of the IRQ handler, DMA completions included
+	nrf24_getProfile( NRF24_PROFILE_IRQ, &irq );
+	if( result->acked > 0 ){
+		result->irq_cycles = (uint32_t)(irq.total / result->acked);
+	}
+#endif
+
+	/* Round trip: one payload at a time, nrf24_transmit to TX_DS (lost payloads are not sampled) */
+	limit = (packets < NRF24_BENCH_MAX_SAMPLES) ? packets : NRF24_BENCH_MAX_SAMPLES;
+	samples = 0;
+	for( i = 0; i < limit; i++ ){
+		memset( payload, (uint8_t)(i & 0x7Fu), size );
+		acked = nrf24_benchAcked;
+
+		start = DWT->CYCCNT;
+		err = nrf24_transmit( payload, size );
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		if( !nrf24_benchDrain( &seen ) ){
+			return NRF24_ERR_TIMEOUT;
+		}
+
+		if( nrf24_benchAcked != acked ){
+			nrf24_benchSamples[samples++] = nrf24_benchCyclesToUs( nrf24_benchDoneCycles - start );
+		}
+	}
+
+	nrf24_benchSort( samples );
+	result->rtt_p50_us = nrf24_benchPercentile( samples, 50 );
+	result->rtt_p90_us = nrf24_benchPercentile( samples, 90 );
+	result->rtt_p99_us = nrf24_benchPercentile( samples, 99 );
+	result->rtt_max_us = nrf24_benchPercentile( samples, 100 );
+
+	/* Role switch: turnarounds with nothing queued, the link is left in PTX */
+	to_prx = 0;
+	to_ptx = 0;
+	for( i = 0; i < NRF24_BENCH_ROLE_SWITCHES; i++ ){
+		t0 = DWT->CYCCNT;
+		err = nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PRX, &bench_config );
+		to_prx += DWT->CYCCNT - t0;
+		if( err != NRF24_OK ){
+			return err;
+		}
+
+		t0 = DWT->CYCCNT;
+		err = nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PTX, &bench_config );
+		to_ptx += DWT->CYCCNT - t0;
+		if( err != NRF24_OK ){
+			return err;
+		}
+	}
+
+	result->to_prx_us = nrf24_benchCyclesToUs( to_prx / NRF24_BENCH_ROLE_SWITCHES );
+	result->to_ptx_us = nrf24_benchCyclesToUs( to_ptx / NRF24_BENCH_ROLE_SWITCHES );
+
+	return NRF24_OK;
+}
+
+/*
+ * nrf24_benchSweep - Runs nrf24_benchRun at @config's data rate for every payload size 1-32
+ * (only payload_width without dpl), printing a CSV line each, then the nrf24_benchCommands line.
+ * Other data rates need the peer reconfigured to them and a sweep per rate.
+ *
+ * nrf24_config_t* @config:	base configuration, see nrf24_benchRun
+ * uint32_t @packets:				# of payloads per phase
+ *
+ * @return: void
+ */
+void nrf24_benchSweep( nrf24_config_t* config, uint32_t packets ){
+	nrf24_bench_cmd_result_t commands;
+	nrf24_bench_result_t result;
+	uint8_t data_rate = nrf24_benchConfigRate( config );
+	uint8_t size, first, last;
+	nrf24_err_t err;
+
+	first = config->dpl ? 1u : config->payload_width;
+	last = config->dpl ? NRF24_MAX_PAYLOAD_SIZE : config->payload_width;
+
+	nrf24_benchPrintHeader();
+
+	for( size = first; size <= last; size++ ){
+		err = nrf24_benchRun( config, data_rate, size, packets, &result );
+		if( err != NRF24_OK ){
+			printf( "# %s,%u,error %u\r\n", nrf24_benchRateName[data_rate], size, err );
+			continue;
+		}
+
+		nrf24_benchPrint( &result );
+	}
+
+	// The driver is initialized by now
+	if( nrf24_benchCommands( &commands ) == NRF24_OK ){
+		nrf24_benchPrintCommands( &commands );
+	}
+}
+
+/*
+ * nrf24_benchPrintHeader - Prints the CSV column names
+ *
+ * @return: void
+ */
+void nrf24_benchPrintHeader( void ){
+	printf( "rate,size,init_us,init_frames,init_reg_us,init_reg_frames,sent,acked,lost,elapsed_us,pps,goodput_bps,submit_cycles,irq_cycles,spi_load_permille,rtt_p50_us,rtt_p90_us,rtt_p99_us,rtt_max_us,to_prx_us,to_ptx_us\r\n" );
+}
+
+/*
+ * nrf24_benchPrint - Prints one result as a CSV line
+ *
+ * nrf24_bench_result_t* @result: measurements
+ *
+ * @return: void
+ */
+void nrf24_benchPrint( nrf24_bench_result_t* result ){
+	printf( "%s,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+		nrf24_benchRateName[result->data_rate], result->size,
+		(unsigned long)result->init_us, (unsigned long)result->init_frames,
+		(unsigned long)result->init_reg_us, (unsigned long)result->init_reg_frames,
+		(unsigned long)result->sent, (unsigned long)result->acked, (unsigned long)result->lost,
+		(unsigned long)result->elapsed_us, (unsigned long)result->pps, (unsigned long)result->goodput_bps,
+		(unsigned long)result->submit_cycles, (unsigned long)result->irq_cycles, (unsigned long)result->spi_load_permille,
+		(unsigned long)result->rtt_p50_us, (unsigned long)result->rtt_p90_us,
+		(unsigned long)result->rtt_p99_us, (unsigned long)result->rtt_max_us,
+		(unsigned long)result->to_prx_us, (unsigned long)result->to_ptx_us );
+}
+
+#endif // NRF24_USE_BENCHMARK
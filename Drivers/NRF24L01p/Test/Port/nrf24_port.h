@@ -0,0 +1,153 @@
+#ifndef NRF24L01P_TEST_PORT_NRF24_PORT_H_
+#define NRF24L01P_TEST_PORT_NRF24_PORT_H_
+
+/*
+ * Host port of the NRF24L01 library (NRF24_PORT_HEADER="nrf24_port.h")
+ * Stands in for stm32f4xx_hal.h and stm32f407xx.h with the subset the driver and the benchmark use.
+ * Peripherals are backed by the simulator (nrf24_sim.h): every DWT, GPIO and EXTI access goes
+ * through an accessor that advances the simulated time, runs the radios and delivers interrupts,
+ * so the driver code runs unmodified against a modelled chip and air link.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/* --- CMSIS --- */
+#define __IO                    volatile
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline __attribute__((always_inline))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __WEAK                  __attribute__((weak))
+
+typedef struct {
+  __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1, CR2, SR, DR, CRCPR, RXCRCR, TXCRCR, I2SCFGR, I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+  __IO uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+  __IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef enum {
+  EXTI0_IRQn        = 6,
+  DMA2_Stream0_IRQn = 56,
+  DMA2_Stream3_IRQn = 59
+} IRQn_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+
+#define SPI_CR1_BR_Pos    3U
+#define SPI_CR1_BR_Msk    (0x7UL << SPI_CR1_BR_Pos)
+#define SPI_CR1_SPE       (1UL << 6)
+#define SPI_SR_RXNE       (1UL << 0)
+#define SPI_SR_TXE        (1UL << 1)
+#define SPI_SR_MODF       (1UL << 5)
+#define SPI_SR_OVR        (1UL << 6)
+#define SPI_SR_BSY        (1UL << 7)
+
+/* Simulated peripherals, see nrf24_sim.c */
+GPIO_TypeDef* nrf24_simGpio( uint8_t port );
+DWT_Type* nrf24_simDwt( void );
+EXTI_TypeDef* nrf24_simExti( void );
+extern SPI_TypeDef nrf24_simSpi1;
+extern CoreDebug_Type nrf24_simCoreDebug;
+
+#define GPIOA       (nrf24_simGpio(0))
+#define GPIOB       (nrf24_simGpio(1))
+#define GPIOC       (nrf24_simGpio(2))
+#define SPI1        (&nrf24_simSpi1)
+#define DWT         (nrf24_simDwt())
+#define CoreDebug   (&nrf24_simCoreDebug)
+#define EXTI        (nrf24_simExti())
+
+extern uint32_t SystemCoreClock;
+
+/* Core intrinsics: a single simulated core, interrupts are only taken at the accessors above */
+uint32_t nrf24_simGetPrimask( void );
+void nrf24_simSetPrimask( uint32_t primask );
+void nrf24_simWaitForInterrupt( void );
+
+__STATIC_FORCEINLINE void __DMB( void ){ __atomic_thread_fence( __ATOMIC_SEQ_CST ); }
+__STATIC_FORCEINLINE void __DSB( void ){ __atomic_thread_fence( __ATOMIC_SEQ_CST ); }
+__STATIC_FORCEINLINE void __ISB( void ){ __atomic_signal_fence( __ATOMIC_SEQ_CST ); }
+__STATIC_FORCEINLINE void __NOP( void ){ }
+__STATIC_FORCEINLINE void __WFI( void ){ nrf24_simWaitForInterrupt(); }
+__STATIC_FORCEINLINE void __disable_irq( void ){ nrf24_simSetPrimask( 1U ); }
+__STATIC_FORCEINLINE void __enable_irq( void ){ nrf24_simSetPrimask( 0U ); }
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK( void ){ return nrf24_simGetPrimask(); }
+__STATIC_FORCEINLINE void __set_PRIMASK( uint32_t primask ){ nrf24_simSetPrimask( primask ); }
+__STATIC_FORCEINLINE uint8_t __CLZ( uint32_t value ){ return (uint8_t)(value ? __builtin_clz( value ) : 32); }
+
+// Exclusive monitor: nothing preempts between LDREX and STREX on the host, so STREX always succeeds
+__STATIC_FORCEINLINE uint32_t __LDREXW( volatile uint32_t* addr ){ return __atomic_load_n( addr, __ATOMIC_SEQ_CST ); }
+__STATIC_FORCEINLINE uint32_t __STREXW( uint32_t value, volatile uint32_t* addr ){ __atomic_store_n( addr, value, __ATOMIC_SEQ_CST ); return 0U; }
+__STATIC_FORCEINLINE uint8_t __LDREXB( volatile uint8_t* addr ){ return __atomic_load_n( addr, __ATOMIC_SEQ_CST ); }
+__STATIC_FORCEINLINE uint32_t __STREXB( uint8_t value, volatile uint8_t* addr ){ __atomic_store_n( addr, value, __ATOMIC_SEQ_CST ); return 0U; }
+__STATIC_FORCEINLINE void __CLREX( void ){ }
+
+
+/* --- HAL --- */
+#define TICK_INT_PRIORITY   0U
+
+typedef enum {
+  HAL_OK      = 0x00U,
+  HAL_ERROR   = 0x01U,
+  HAL_BUSY    = 0x02U,
+  HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0    ((uint16_t)0x0001)
+#define GPIO_PIN_4    ((uint16_t)0x0010)
+#define GPIO_PIN_5    ((uint16_t)0x0020)
+#define GPIO_PIN_6    ((uint16_t)0x0040)
+#define GPIO_PIN_7    ((uint16_t)0x0080)
+
+#define SPI_BAUDRATEPRESCALER_2     (0x00000000U)
+#define SPI_BAUDRATEPRESCALER_16    (0x00000018U)
+
+typedef struct {
+  uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+  SPI_TypeDef* Instance;
+  SPI_InitTypeDef Init;
+  __IO uint32_t ErrorCode;
+} SPI_HandleTypeDef;
+
+#define __HAL_GPIO_EXTI_GENERATE_SWIT(__EXTI_LINE__)  (EXTI->SWIER |= (__EXTI_LINE__))
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive( SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size, uint32_t Timeout );
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA( SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size );
+HAL_StatusTypeDef HAL_SPI_Abort( SPI_HandleTypeDef* hspi );
+void HAL_SPI_TxRxCpltCallback( SPI_HandleTypeDef* hspi );
+void HAL_SPI_ErrorCallback( SPI_HandleTypeDef* hspi );
+
+void HAL_GPIO_WritePin( GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState );
+GPIO_PinState HAL_GPIO_ReadPin( GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin );
+void HAL_GPIO_EXTI_IRQHandler( uint16_t GPIO_Pin );
+void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin );
+
+uint32_t HAL_GetTick( void );
+void HAL_Delay( uint32_t Delay );
+uint32_t HAL_RCC_GetPCLK2Freq( void );
+
+#endif // NRF24L01P_TEST_PORT_NRF24_PORT_H_
@@ -0,0 +1,116 @@
+#ifndef NRF24L01P_TEST_SIM_NRF24_SIM_H_
+#define NRF24L01P_TEST_SIM_NRF24_SIM_H_
+
+/*
+ * Host simulator of the NRF24L01 library's hardware
+ * MCU side (nrf24_sim_mcu.c): cycle counter, SysTick, NVIC priorities and PRIMASK, GPIO (BSRR/ODR),
+ * EXTI0 on the IRQ line, SPI1 polling and DMA transfers, the HAL calls the driver makes.
+ * Radio side (nrf24_sim_radio.c): two nRF24L01+ chips, the device under test on SPI1/CE/IRQ and a peer
+ * driven by the test, each with its register file, 3-level FIFOs, STATUS/IRQ line, Tpd2stby and
+ * Tstby2a timing, Enhanced ShockBurst (ACK, ACK payloads, ARD/ARC retransmits, MAX_RT, PLOS_CNT)
+ * and an air link between them with loss injection.
+ * Time only moves at the port accessors (DWT, HAL_GetTick, HAL_GPIO_ReadPin, SPI transfers) and in
+ * nrf24_simRunUs, interrupts are taken there as on the core: by priority, masked by PRIMASK.
+ */
+
+#include "nrf24_port.h"
+#include "../../Inc/nrf24l01p.h"
+
+
+/* Radios */
+#define NRF24_SIM_DUT           0   // SPI1, CE = PC4, NSS = PC5, IRQ = PB0
+#define NRF24_SIM_PEER          1   // driven by the test through nrf24_simCommand/nrf24_simSetCe
+#define NRF24_SIM_RADIO_COUNT   2
+
+/* Frames kept in the SPI frame log */
+#define NRF24_SIM_FRAME_LOG     256
+
+/* MCU-side counters */
+typedef struct {
+  uint32_t spi_frames;            // DUT frames, polling and DMA
+  uint32_t spi_bytes;
+  uint32_t dma_frames;
+  uint32_t isr_polled_frames;     // polling frames clocked from interrupt context
+  uint32_t isr_polled_bytes;
+  uint32_t exti_runs;             // EXTI0 handler entries
+  uint32_t dma_irqs;              // DMA completion/error interrupts
+  uint64_t isr_cycles;            // cycles spent in EXTI0 and DMA handlers (nested ones included)
+  uint64_t dma_thread_cycles;     // thread-context cycles that elapsed while a DMA frame was on the bus
+  uint32_t violations;            // accesses the real hardware would not tolerate (see nrf24_simViolation)
+} nrf24_sim_stats_t;
+
+/* Radio counters */
+typedef struct {
+  uint32_t air_packets;           // packets put on air, retransmits included
+  uint32_t received;              // new packets put into the RX FIFO
+  uint32_t duplicates;            // retransmits of a packet already received (ACKed, discarded)
+  uint32_t dropped_full;          // packets not received because the RX FIFO was full
+  uint32_t acks;                  // ACKs sent
+  uint32_t ack_payloads;          // ACKs that carried a payload
+  uint32_t tx_ds;
+  uint32_t max_rt;
+  uint32_t early_starts;          // TX/RX requested (CE high) before Tpd2stby elapsed
+} nrf24_sim_radio_stats_t;
+
+/* SPI frame log entry */
+typedef struct {
+  uint64_t at;                    // start, in cycles
+  uint8_t cmd;
+  uint8_t length;                 // command byte included
+  uint8_t dma;                    // TRUE = DMA transfer
+  uint8_t isr;                    // TRUE = started from interrupt context
+} nrf24_sim_frame_t;
+
+/* --- MCU --- */
+void nrf24_simReset( void );
+uint64_t nrf24_simNow( void );
+uint64_t nrf24_simUsToCycles( uint32_t us );
+void nrf24_simStep( uint32_t cycles );
+void nrf24_simRunUs( uint32_t us );
+uint8_t nrf24_simRunUntil( uint8_t (*done)( void ), uint32_t timeout_us );
+uint8_t nrf24_simInIsr( void );
+uint8_t nrf24_simDmaBusy( void );
+void nrf24_simSetDmaPriority( uint8_t priority );
+void nrf24_simViolation( const char* what );
+void nrf24_simGetStats( nrf24_sim_stats_t* stats );
+uint32_t nrf24_simFrameCount( void );
+const nrf24_sim_frame_t* nrf24_simFrame( uint32_t index );
+
+// Fault injection: after @skip more frames, the next @count ones fail
+void nrf24_simFailSpi( uint32_t skip, uint32_t count, HAL_StatusTypeDef status );
+void nrf24_simFailDmaStart( uint32_t skip, uint32_t count );
+void nrf24_simFailDmaTransfer( uint32_t skip, uint32_t count );
+
+// Called in the middle of every DUT frame: STATUS is clocked out, the command not executed yet
+void nrf24_simFrameHook( void (*hook)( uint8_t cmd ) );
+
+/* --- Radios --- */
+void nrf24_simRadioReset( void );
+void nrf24_simRadioAdvance( uint64_t now );
+uint8_t nrf24_simRadioStatus( uint8_t radio, uint64_t now );
+void nrf24_simRadioExecute( uint8_t radio, const uint8_t* frame, uint8_t* reply, uint8_t length, uint64_t now );
+void nrf24_simRadioSetCe( uint8_t radio, uint8_t level, uint64_t now );
+uint8_t nrf24_simRadioIrq( uint8_t radio );
+
+uint8_t nrf24_simCommand( uint8_t radio, const uint8_t* frame, uint8_t* reply, uint8_t length );
+void nrf24_simWriteReg( uint8_t radio, uint8_t reg, const uint8_t* data, uint8_t size );
+uint8_t nrf24_simReadReg( uint8_t radio, uint8_t reg );
+void nrf24_simSetCe( uint8_t radio, uint8_t level );
+void nrf24_simRaise( uint8_t radio, uint8_t flags );
+uint8_t nrf24_simInjectRx( uint8_t radio, uint8_t pipe, const uint8_t* data, uint8_t size );
+uint8_t nrf24_simTxLevel( uint8_t radio );
+uint8_t nrf24_simRxLevel( uint8_t radio );
+void nrf24_simGetRadioStats( uint8_t radio, nrf24_sim_radio_stats_t* stats );
+
+// Air link: packets (and ACKs) sent by @radio are lost with a probability of @permille, or the next @count ones
+void nrf24_simLoss( uint8_t radio, uint16_t packet_permille, uint16_t ack_permille );
+void nrf24_simDropNext( uint8_t radio, uint32_t count );
+void nrf24_simNoise( uint8_t channel, uint8_t busy );
+
+// Peer side: @hook sees every new packet it receives, auto-drain pops it right away (a fast consumer)
+void nrf24_simPeerHook( void (*hook)( uint8_t pipe, const uint8_t* data, uint8_t size ) );
+void nrf24_simPeerAutoDrain( uint8_t enable );
+// Peer's firmware: @task runs whenever the simulation catches up (after the radio events), drives the peer through nrf24_simCommand/SetCe
+void nrf24_simPeerTask( void (*task)( void ) );
+
+#endif // NRF24L01P_TEST_SIM_NRF24_SIM_H_
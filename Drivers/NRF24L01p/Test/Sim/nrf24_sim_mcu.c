@@ -0,0 +1,718 @@
+/*
+ * Host simulator of the NRF24L01 library: MCU side (STM32F407 at 168MHz, SPI1 on APB2 at 84MHz)
+ * See nrf24_sim.h
+ */
+
+
+/* Header file */
+#include "nrf24_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+
+/* --- Cost model, in core cycles --- */
+#define SIM_CYCLES_DWT_READ       4     // DWT->CYCCNT load
+#define SIM_CYCLES_GET_TICK       8     // HAL_GetTick call
+#define SIM_CYCLES_GPIO_CALL      24    // HAL_GPIO_ReadPin/WritePin call
+#define SIM_CYCLES_HAL_SPI        180   // HAL_SPI_TransmitReceive set-up and flag polling around the bytes
+#define SIM_CYCLES_HAL_SPI_DMA    140   // HAL_SPI_TransmitReceive_DMA set-up of both streams
+#define SIM_CYCLES_DMA_LATENCY    40    // last byte to DMA completion interrupt
+#define SIM_CYCLES_EXCEPTION      12    // exception entry (stacking)
+#define SIM_CYCLES_IDLE           168   // one __WFI / nrf24_simRunUs slice (1us)
+
+#define SIM_APB2_FREQ             84000000u
+
+/* Interrupt sources */
+enum {
+	SIM_IRQ_SYSTICK = 0,
+	SIM_IRQ_EXTI0,
+	SIM_IRQ_DMA,
+	SIM_IRQ_COUNT
+};
+
+#define SIM_PRIORITY_THREAD       256
+
+
+/* --- Peripherals seen by the port header --- */
+uint32_t SystemCoreClock = 168000000u;
+SPI_TypeDef nrf24_simSpi1;
+CoreDebug_Type nrf24_simCoreDebug;
+SPI_HandleTypeDef hspi1 = { &nrf24_simSpi1, { SPI_BAUDRATEPRESCALER_16 }, 0 };
+
+static GPIO_TypeDef sim_gpio[3];
+static DWT_Type sim_dwt;
+static EXTI_TypeDef sim_exti;
+
+
+/* --- Core state --- */
+static uint64_t sim_now;
+static uint32_t sim_tick;
+static uint64_t sim_nextTick;
+static uint32_t sim_primask;
+static uint32_t sim_pending;
+static uint16_t sim_activePriority = SIM_PRIORITY_THREAD;
+static uint8_t sim_depth;
+static uint8_t sim_priority[SIM_IRQ_COUNT];
+static uint8_t sim_irqLine = 1;
+static uint8_t sim_ce;
+static uint8_t sim_syncing;
+
+/* --- SPI/DMA state --- */
+static struct {
+	uint8_t active;
+	uint8_t fail;
+	uint8_t* rx;
+	uint16_t size;
+	uint64_t done_at;
+	uint8_t reply[NRF24_MAX_FRAME_SIZE];
+} sim_dma;
+
+typedef struct {
+	uint32_t skip;
+	uint32_t count;
+	HAL_StatusTypeDef status;
+} sim_fail_t;
+
+static sim_fail_t sim_failSpi;
+static sim_fail_t sim_failDmaStart;
+static sim_fail_t sim_failDmaTransfer;
+
+static void (*sim_frameHook)( uint8_t cmd );
+static void (*sim_peerTask)( void );
+
+static nrf24_sim_stats_t sim_stats;
+static nrf24_sim_frame_t sim_frameLog[NRF24_SIM_FRAME_LOG];
+static uint32_t sim_frameCount;
+
+
+/* --- Local functions --- */
+static void sim_advance( uint64_t cycles );
+
+/*
+ * sim_failNow - Consumes one frame of a fault injection
+ *
+ * sim_fail_t* @fail: injection to be checked
+ *
+ * @return: TRUE if this frame fails
+ */
+static uint8_t sim_failNow( sim_fail_t* fail ){
+	if( fail->skip > 0 ){
+		fail->skip--;
+		return FALSE;
+	}
+
+	if( fail->count > 0 ){
+		fail->count--;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * sim_gpioSync - Applies a BSRR store to ODR (the store lands after the accessor returned the port)
+ *
+ * GPIO_TypeDef* @port: port to be synced
+ *
+ * @return: void
+ */
+static void sim_gpioSync( GPIO_TypeDef* port ){
+	uint32_t bsrr = port->BSRR;
+
+	if( bsrr != 0 ){
+		port->ODR = (port->ODR | (bsrr & 0xFFFFu)) & ~(bsrr >> 16);
+		port->BSRR = 0;
+	}
+}
+
+/*
+ * sim_sync - Brings every peripheral up to the current time: pin stores, CE edges, EXTI software
+ * triggers, radio events, the IRQ line, SysTick and the DMA completion. Raises pending interrupts only.
+ *
+ * @return: void
+ */
+static void sim_sync( void ){
+	uint8_t port, ce, line;
+
+	if( sim_syncing ){
+		return;
+	}
+	sim_syncing = TRUE;
+
+	for( port = 0; port < 3; port++ ){
+		sim_gpioSync( &sim_gpio[port] );
+	}
+
+	ce = (sim_gpio[2].ODR & NRF24_CE_PIN) ? 1 : 0;
+	if( ce != sim_ce ){
+		sim_ce = ce;
+		nrf24_simRadioSetCe( NRF24_SIM_DUT, ce, sim_now );
+	}
+
+	if( sim_exti.SWIER & NRF24_IRQ_PIN ){
+		sim_exti.SWIER &= ~(uint32_t)NRF24_IRQ_PIN;
+		sim_pending |= 0b1u << SIM_IRQ_EXTI0;
+	}
+
+	nrf24_simRadioAdvance( sim_now );
+
+	// The peer's MCU reacts to what its radio just did, its nrf24_simCommand calls do not re-enter sim_sync
+	if( sim_peerTask != NULL ){
+		sim_peerTask();
+	}
+
+	// Falling edge on PB0
+	line = nrf24_simRadioIrq( NRF24_SIM_DUT );
+	if( sim_irqLine && !line ){
+		sim_pending |= 0b1u << SIM_IRQ_EXTI0;
+	}
+	sim_irqLine = line;
+
+	if( sim_now >= sim_nextTick ){
+		while( sim_now >= sim_nextTick ){
+			sim_nextTick += SystemCoreClock / 1000u;
+		}
+		sim_pending |= 0b1u << SIM_IRQ_SYSTICK;
+	}
+
+	if( sim_dma.active && sim_now >= sim_dma.done_at ){
+		sim_pending |= 0b1u << SIM_IRQ_DMA;
+	}
+
+	sim_syncing = FALSE;
+}
+
+/*
+ * sim_vector - Runs the handler of an interrupt source, as stm32f4xx_it.c does on the board
+ *
+ * uint8_t @irq: SIM_IRQ_xx
+ *
+ * @return: void
+ */
+static void sim_vector( uint8_t irq ){
+	switch( irq ){
+		case SIM_IRQ_SYSTICK:
+			sim_tick++;
+			nrf24_tick();
+			break;
+
+		case SIM_IRQ_EXTI0:
+			sim_stats.exti_runs++;
+			HAL_GPIO_EXTI_IRQHandler( NRF24_IRQ_PIN );
+			break;
+
+		case SIM_IRQ_DMA:
+			sim_stats.dma_irqs++;
+			sim_dma.active = FALSE;
+			if( sim_dma.fail ){
+				HAL_SPI_ErrorCallback( &hspi1 );
+			} else {
+				memcpy( sim_dma.rx, sim_dma.reply, sim_dma.size );
+				HAL_SPI_TxRxCpltCallback( &hspi1 );
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*
+ * sim_dispatch - Takes every pending interrupt that preempts the running context, highest priority first
+ *
+ * @return: void
+ */
+static void sim_dispatch( void ){
+	uint16_t saved;
+	uint64_t start;
+	int8_t best;
+	uint8_t irq;
+
+	for( ;; ){
+		if( sim_primask ){
+			return;
+		}
+
+		best = -1;
+		for( irq = 0; irq < SIM_IRQ_COUNT; irq++ ){
+			if( ((sim_pending >> irq) & 0b1u) && sim_priority[irq] < sim_activePriority
+				&& (best < 0 || sim_priority[irq] < sim_priority[best]) ){
+				best = (int8_t)irq;
+			}
+		}
+		if( best < 0 ){
+			return;
+		}
+
+		sim_pending &= ~(0b1u << best);
+		saved = sim_activePriority;
+		sim_activePriority = sim_priority[best];
+		sim_depth++;
+		start = sim_now;
+
+		sim_now += SIM_CYCLES_EXCEPTION;
+		sim_vector( (uint8_t)best );
+
+		if( best != SIM_IRQ_SYSTICK && sim_depth == 1 ){
+			sim_stats.isr_cycles += sim_now - start;
+		}
+		sim_depth--;
+		sim_activePriority = saved;
+	}
+}
+
+/*
+ * sim_advance - Lets @cycles go by on the running context, then syncs and takes interrupts
+ *
+ * uint64_t @cycles: # of cycles
+ *
+ * @return: void
+ */
+static void sim_advance( uint64_t cycles ){
+	if( sim_depth == 0 && sim_dma.active ){
+		sim_stats.dma_thread_cycles += cycles;
+	}
+
+	sim_now += cycles;
+	sim_sync();
+	sim_dispatch();
+}
+
+/*
+ * sim_byteCycles - Duration of one SPI byte from the prescaler of hspi1 and the APB2 clock
+ *
+ * @return: # of core cycles
+ */
+static uint32_t sim_byteCycles( void ){
+	uint32_t divider = 2u << ((hspi1.Init.BaudRatePrescaler & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos);
+
+	return (8u * SystemCoreClock) / (SIM_APB2_FREQ / divider);
+}
+
+/*
+ * sim_logFrame - Counts a DUT frame and appends it to the frame log
+ *
+ * uint8_t @cmd:		command byte
+ * uint16_t @length:	# of bytes, command included
+ * uint8_t @dma:		TRUE for a DMA transfer
+ *
+ * @return: void
+ */
+static void sim_logFrame( uint8_t cmd, uint16_t length, uint8_t dma ){
+	nrf24_sim_frame_t* frame = &sim_frameLog[sim_frameCount % NRF24_SIM_FRAME_LOG];
+
+	frame->at = sim_now;
+	frame->cmd = cmd;
+	frame->length = (uint8_t)length;
+	frame->dma = dma;
+	frame->isr = (sim_depth > 0);
+	sim_frameCount++;
+
+	sim_stats.spi_frames++;
+	sim_stats.spi_bytes += length;
+	if( dma ){
+		sim_stats.dma_frames++;
+	} else if( sim_depth > 0 ){
+		sim_stats.isr_polled_frames++;
+		sim_stats.isr_polled_bytes += length;
+	}
+}
+
+/*
+ * sim_frame - Runs a DUT frame on the chip: STATUS out first, the mid-frame hook, then the command
+ *
+ * uint8_t* @tx:		frame, command byte first
+ * uint8_t* @rx:		reply, STATUS first
+ * uint16_t @length:	# of bytes
+ *
+ * @return: void
+ */
+static void sim_frame( uint8_t* tx, uint8_t* rx, uint16_t length ){
+	if( sim_gpio[2].ODR & NRF24_NSS_PIN ){
+		nrf24_simViolation( "SPI frame with NSS high" );
+	}
+
+	rx[0] = nrf24_simRadioStatus( NRF24_SIM_DUT, sim_now );
+
+	if( sim_frameHook != NULL ){
+		sim_frameHook( tx[0] );
+	}
+
+	nrf24_simRadioExecute( NRF24_SIM_DUT, tx, rx, (uint8_t)length, sim_now );
+}
+
+
+
+/* --- Port accessors --- */
+
+GPIO_TypeDef* nrf24_simGpio( uint8_t port ){
+	sim_gpioSync( &sim_gpio[port] );
+	return &sim_gpio[port];
+}
+
+DWT_Type* nrf24_simDwt( void ){
+	sim_advance( SIM_CYCLES_DWT_READ );
+	sim_dwt.CYCCNT = (uint32_t)sim_now;
+	return &sim_dwt;
+}
+
+EXTI_TypeDef* nrf24_simExti( void ){
+	return &sim_exti;
+}
+
+uint32_t nrf24_simGetPrimask( void ){
+	return sim_primask;
+}
+
+void nrf24_simSetPrimask( uint32_t primask ){
+	sim_primask = primask;
+
+	// Interrupts that came in while masked are taken right away
+	if( !primask ){
+		sim_sync();
+		sim_dispatch();
+	}
+}
+
+void nrf24_simWaitForInterrupt( void ){
+	sim_advance( SIM_CYCLES_IDLE );
+}
+
+
+
+/* --- HAL --- */
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive( SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size, uint32_t Timeout ){
+	uint64_t duration = SIM_CYCLES_HAL_SPI + (uint64_t)Size * sim_byteCycles();
+
+	(void)hspi;
+	sim_sync();
+
+	if( sim_dma.active ){
+		nrf24_simViolation( "polling frame while a DMA frame is on the bus" );
+		return HAL_BUSY;
+	}
+
+	if( sim_failNow( &sim_failSpi ) ){
+		// A timeout burns its whole budget
+		sim_advance( (sim_failSpi.status == HAL_TIMEOUT) ? (uint64_t)Timeout * (SystemCoreClock / 1000u) : duration );
+		return sim_failSpi.status;
+	}
+
+	sim_logFrame( pTxData[0], Size, FALSE );
+	sim_frame( pTxData, pRxData, Size );
+
+	// Interrupts preempt the transfer, the bytes keep their timing
+	sim_advance( duration );
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA( SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size ){
+	(void)hspi;
+	sim_sync();
+
+	if( sim_dma.active ){
+		return HAL_BUSY;
+	}
+
+	if( sim_failNow( &sim_failDmaStart ) ){
+		sim_advance( SIM_CYCLES_HAL_SPI_DMA );
+		return HAL_ERROR;
+	}
+
+	sim_logFrame( pTxData[0], Size, TRUE );
+
+	sim_dma.fail = sim_failNow( &sim_failDmaTransfer );
+	if( !sim_dma.fail ){
+		sim_frame( pTxData, sim_dma.reply, Size );
+	}
+	sim_dma.rx = pRxData;
+	sim_dma.size = Size;
+	sim_dma.done_at = sim_now + SIM_CYCLES_HAL_SPI_DMA + (uint64_t)Size * sim_byteCycles() + SIM_CYCLES_DMA_LATENCY;
+	sim_dma.active = TRUE;
+
+	sim_advance( SIM_CYCLES_HAL_SPI_DMA );
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort( SPI_HandleTypeDef* hspi ){
+	(void)hspi;
+
+	sim_dma.active = FALSE;
+	sim_pending &= ~(0b1u << SIM_IRQ_DMA);
+
+	return HAL_OK;
+}
+
+__WEAK void HAL_SPI_TxRxCpltCallback( SPI_HandleTypeDef* hspi ){
+	(void)hspi;
+}
+
+__WEAK void HAL_SPI_ErrorCallback( SPI_HandleTypeDef* hspi ){
+	(void)hspi;
+}
+
+void HAL_GPIO_WritePin( GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState ){
+	sim_gpioSync( GPIOx );
+
+	if( PinState != GPIO_PIN_RESET ){
+		GPIOx->ODR |= GPIO_Pin;
+	} else {
+		GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+	}
+
+	sim_advance( SIM_CYCLES_GPIO_CALL );
+}
+
+GPIO_PinState HAL_GPIO_ReadPin( GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin ){
+	sim_advance( SIM_CYCLES_GPIO_CALL );
+
+	if( GPIOx == &sim_gpio[1] && GPIO_Pin == NRF24_IRQ_PIN ){
+		return nrf24_simRadioIrq( NRF24_SIM_DUT ) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+	}
+
+	return (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_EXTI_IRQHandler( uint16_t GPIO_Pin ){
+	sim_exti.PR = GPIO_Pin;
+	HAL_GPIO_EXTI_Callback( GPIO_Pin );
+}
+
+// main.c routes the IRQ line to the driver
+__WEAK void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin ){
+	if( GPIO_Pin == NRF24_IRQ_PIN ){
+		nrf24_irqHandler();
+	}
+}
+
+uint32_t HAL_GetTick( void ){
+	sim_advance( SIM_CYCLES_GET_TICK );
+	return sim_tick;
+}
+
+void HAL_Delay( uint32_t Delay ){
+	uint32_t start = HAL_GetTick();
+
+	while( (HAL_GetTick() - start) < Delay + 1u ){
+		sim_advance( SIM_CYCLES_IDLE );
+	}
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq( void ){
+	return SIM_APB2_FREQ;
+}
+
+
+
+/* --- Simulator APIs --- */
+
+/*
+ * nrf24_simReset - Power-on state: time 0, NSS high, CE low, both radios at their reset values
+ *
+ * @return: void
+ */
+void nrf24_simReset( void ){
+	memset( sim_gpio, 0, sizeof(sim_gpio) );
+	memset( &sim_dwt, 0, sizeof(sim_dwt) );
+	memset( &sim_exti, 0, sizeof(sim_exti) );
+	memset( &sim_dma, 0, sizeof(sim_dma) );
+	memset( &sim_stats, 0, sizeof(sim_stats) );
+	memset( &sim_failSpi, 0, sizeof(sim_failSpi) );
+	memset( &sim_failDmaStart, 0, sizeof(sim_failDmaStart) );
+	memset( &sim_failDmaTransfer, 0, sizeof(sim_failDmaTransfer) );
+
+	sim_now = 0;
+	sim_tick = 0;
+	sim_nextTick = SystemCoreClock / 1000u;
+	sim_primask = 0;
+	sim_pending = 0;
+	sim_activePriority = SIM_PRIORITY_THREAD;
+	sim_depth = 0;
+	sim_irqLine = 1;
+	sim_ce = 0;
+	sim_frameHook = NULL;
+	sim_peerTask = NULL;
+	sim_frameCount = 0;
+
+	// NVIC set-up of main.c
+	sim_priority[SIM_IRQ_SYSTICK] = TICK_INT_PRIORITY;
+	sim_priority[SIM_IRQ_EXTI0] = NRF24_IRQ_NVIC_PRIORITY;
+	sim_priority[SIM_IRQ_DMA] = NRF24_IRQ_NVIC_PRIORITY;
+
+	sim_gpio[2].ODR = NRF24_NSS_PIN;
+
+	nrf24_simRadioReset();
+}
+
+uint64_t nrf24_simNow( void ){
+	return sim_now;
+}
+
+uint64_t nrf24_simUsToCycles( uint32_t us ){
+	return (uint64_t)us * (SystemCoreClock / 1000000u);
+}
+
+/*
+ * nrf24_simStep - Lets @cycles go by on the running context (thread code of a test)
+ *
+ * uint32_t @cycles: # of cycles
+ *
+ * @return: void
+ */
+void nrf24_simStep( uint32_t cycles ){
+	sim_advance( cycles );
+}
+
+/*
+ * nrf24_simRunUs - Idles the thread for @us, interrupts and radios keep running
+ *
+ * uint32_t @us: # of microseconds
+ *
+ * @return: void
+ */
+void nrf24_simRunUs( uint32_t us ){
+	uint64_t end = sim_now + nrf24_simUsToCycles( us );
+
+	while( sim_now < end ){
+		sim_advance( (end - sim_now < SIM_CYCLES_IDLE) ? (end - sim_now) : SIM_CYCLES_IDLE );
+	}
+}
+
+/*
+ * nrf24_simRunUntil - Idles the thread until @done returns TRUE
+ *
+ * uint8_t (*@done)(void):	condition, checked every simulated microsecond
+ * uint32_t @timeout_us:	longest wait
+ *
+ * @return: TRUE if @done, FALSE on timeout
+ */
+uint8_t nrf24_simRunUntil( uint8_t (*done)( void ), uint32_t timeout_us ){
+	uint64_t end = sim_now + nrf24_simUsToCycles( timeout_us );
+
+	while( !done() ){
+		if( sim_now >= end ){
+			return FALSE;
+		}
+		sim_advance( SIM_CYCLES_IDLE );
+	}
+
+	return TRUE;
+}
+
+uint8_t nrf24_simInIsr( void ){
+	return sim_depth > 0;
+}
+
+uint8_t nrf24_simDmaBusy( void ){
+	return sim_dma.active;
+}
+
+/*
+ * nrf24_simSetDmaPriority - NVIC preemption priority of the SPI1 DMA streams (main.c: MX_DMA_Init)
+ *
+ * uint8_t @priority: 0-15
+ *
+ * @return: void
+ */
+void nrf24_simSetDmaPriority( uint8_t priority ){
+	sim_priority[SIM_IRQ_DMA] = priority;
+}
+
+/*
+ * nrf24_simViolation - Counts (and prints) an access the real hardware would not tolerate
+ *
+ * const char* @what: description
+ *
+ * @return: void
+ */
+void nrf24_simViolation( const char* what ){
+	sim_stats.violations++;
+	printf( "sim: violation at %llu cycles: %s\n", (unsigned long long)sim_now, what );
+}
+
+void nrf24_simGetStats( nrf24_sim_stats_t* stats ){
+	*stats = sim_stats;
+}
+
+uint32_t nrf24_simFrameCount( void ){
+	return sim_frameCount;
+}
+
+/*
+ * nrf24_simFrame - Entry of the frame log
+ *
+ * uint32_t @index: 0 = first frame since nrf24_simReset (only the last NRF24_SIM_FRAME_LOG are kept)
+ *
+ * @return: entry, NULL if not kept
+ */
+const nrf24_sim_frame_t* nrf24_simFrame( uint32_t index ){
+	if( index >= sim_frameCount || sim_frameCount - index > NRF24_SIM_FRAME_LOG ){
+		return NULL;
+	}
+
+	return &sim_frameLog[index % NRF24_SIM_FRAME_LOG];
+}
+
+void nrf24_simFailSpi( uint32_t skip, uint32_t count, HAL_StatusTypeDef status ){
+	sim_failSpi.skip = skip;
+	sim_failSpi.count = count;
+	sim_failSpi.status = status;
+}
+
+void nrf24_simFailDmaStart( uint32_t skip, uint32_t count ){
+	sim_failDmaStart.skip = skip;
+	sim_failDmaStart.count = count;
+}
+
+void nrf24_simFailDmaTransfer( uint32_t skip, uint32_t count ){
+	sim_failDmaTransfer.skip = skip;
+	sim_failDmaTransfer.count = count;
+}
+
+void nrf24_simFrameHook( void (*hook)( uint8_t cmd ) ){
+	sim_frameHook = hook;
+}
+
+void nrf24_simPeerTask( void (*task)( void ) ){
+	sim_peerTask = task;
+}
+
+/*
+ * nrf24_simCommand - Runs one SPI frame on a radio outside of SPI1 (the peer's own MCU)
+ *
+ * uint8_t @radio:			NRF24_SIM_xx
+ * const uint8_t* @frame:	command byte followed by its data bytes
+ * uint8_t* @reply:			@length bytes, STATUS first (NULL = discard)
+ * uint8_t @length:			# of frame bytes (command included)
+ *
+ * @return: STATUS
+ */
+uint8_t nrf24_simCommand( uint8_t radio, const uint8_t* frame, uint8_t* reply, uint8_t length ){
+	uint8_t scratch[NRF24_MAX_FRAME_SIZE];
+	uint8_t* out = (reply != NULL) ? reply : scratch;
+
+	sim_sync();
+
+	out[0] = nrf24_simRadioStatus( radio, sim_now );
+	nrf24_simRadioExecute( radio, frame, out, length, sim_now );
+
+	sim_sync();
+	return out[0];
+}
+
+/*
+ * nrf24_simSetCe - Drives the CE pin of the peer (the DUT's is PC4)
+ *
+ * uint8_t @radio: NRF24_SIM_PEER
+ * uint8_t @level: 0/1
+ *
+ * @return: void
+ */
+void nrf24_simSetCe( uint8_t radio, uint8_t level ){
+	sim_sync();
+	nrf24_simRadioSetCe( radio, level, sim_now );
+	sim_sync();
+}
@@ -0,0 +1,829 @@
+/*
+ * Host simulator of the NRF24L01 library: nRF24L01+ chips and the air link between them
+ * See nrf24_sim.h. Timing follows the datasheet: Tpd2stby 1.5ms, Tstby2a 130us, packet air time from
+ * preamble + address + PCF + payload + CRC at the configured data rate, ARD counted from the end of
+ * a transmission to the start of the retransmit.
+ */
+
+
+/* Header file */
+#include "nrf24_sim.h"
+#include <string.h>
+
+
+#define SIM_REG_COUNT         0x1E
+#define SIM_FIFO_LEVELS       3
+#define SIM_NO_EVENT          UINT64_MAX
+
+#define SIM_STATUS_FLAGS      0x70u   // RX_DR, TX_DS, MAX_RT
+#define SIM_RX_DR             (0b1u << NRF24_REG_STATUS_RX_DR_Pos)
+#define SIM_TX_DS             (0b1u << NRF24_REG_STATUS_TX_DS_Pos)
+#define SIM_MAX_RT            (0b1u << NRF24_REG_STATUS_MAX_RT_Pos)
+
+/* Radio states, besides the ones the CE pin and CONFIG tell */
+enum {
+	SIM_IDLE = 0,     // Power-down, Standby-I/II or RX
+	SIM_TX_SETTLE,    // Standby -> TX, 130us
+	SIM_TX_AIR,       // packet on air
+	SIM_ACK_WAIT      // waiting for the ACK, or ARD before a retransmit
+};
+
+typedef struct {
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size;
+	uint8_t pipe;       // RX: pipe it was received on; ACK payload: pipe it answers
+	uint8_t noack;      // W_TX_PAYLOAD_NOACK
+	uint8_t ack;        // W_ACK_PAYLOAD entry (PRX)
+	uint8_t pid;
+} sim_payload_t;
+
+typedef struct {
+	uint8_t reg[SIM_REG_COUNT];
+	uint8_t addr[3][NRF24_ADDR_MAX_WIDTH];    // RX_ADDR_P0, RX_ADDR_P1, TX_ADDR
+
+	sim_payload_t tx[SIM_FIFO_LEVELS];
+	uint8_t tx_count;
+	sim_payload_t rx[SIM_FIFO_LEVELS];
+	uint8_t rx_count;
+
+	uint8_t flags;                            // RX_DR/TX_DS/MAX_RT
+	uint8_t arc_cnt;
+	uint8_t plos_cnt;
+	uint8_t pid;
+
+	uint8_t ce;
+	uint64_t ce_rise;
+	uint64_t mode_at;                         // last PRIM_RX change
+	uint64_t ready_at;                        // end of Tpd2stby
+
+	uint8_t state;
+	uint64_t event_at;
+	uint8_t acked;                            // the packet on air will be ACKed
+	sim_payload_t ack_in;                     // ACK payload on its way back
+
+	uint8_t rx_valid[NRF24_PIPE_COUNT];       // duplicate detection: PID and checksum of the last packet
+	uint8_t rx_pid[NRF24_PIPE_COUNT];
+	uint16_t rx_sum[NRF24_PIPE_COUNT];
+
+	uint16_t loss_permille;                   // packets sent by this radio lost on air
+	uint16_t ack_loss_permille;               // ACKs sent by this radio lost on air
+	uint32_t drop_next;
+
+	nrf24_sim_radio_stats_t stats;
+} sim_radio_t;
+
+static sim_radio_t sim_radio[NRF24_SIM_RADIO_COUNT];
+static uint8_t sim_noise[NRF24_CHANNEL_COUNT];
+static uint32_t sim_random = 0x2545F491u;
+static void (*sim_peerHook)( uint8_t pipe, const uint8_t* data, uint8_t size );
+static uint8_t sim_peerAutoDrain;
+
+
+/* --- Local functions --- */
+static void sim_evaluate( sim_radio_t* r, uint64_t now );
+
+/*
+ * sim_lost - Draws a loss with a probability of @permille (xorshift32, reproducible across runs)
+ *
+ * uint16_t @permille: 0-1000
+ *
+ * @return: TRUE if lost
+ */
+static uint8_t sim_lost( uint16_t permille ){
+	if( permille == 0 ){
+		return FALSE;
+	}
+
+	sim_random ^= sim_random << 13;
+	sim_random ^= sim_random >> 17;
+	sim_random ^= sim_random << 5;
+	return (sim_random % 1000u) < permille;
+}
+
+static uint64_t sim_us( uint32_t us ){
+	return nrf24_simUsToCycles( us );
+}
+
+static uint8_t sim_powered( sim_radio_t* r ){
+	return (r->reg[NRF24_REG_CONFIG] >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u;
+}
+
+static uint8_t sim_isPrx( sim_radio_t* r ){
+	return (r->reg[NRF24_REG_CONFIG] >> NRF24_REG_CONFIG_PRIM_RX_Pos) & 0b1u;
+}
+
+static uint8_t sim_aw( sim_radio_t* r ){
+	return (uint8_t)((r->reg[NRF24_REG_SETUP_AW] & 0b11u) + 2u);
+}
+
+static uint32_t sim_bitRate( sim_radio_t* r ){
+	uint8_t rf_setup = r->reg[NRF24_REG_RF_SETUP];
+
+	if( (rf_setup >> NRF24_REG_RF_SETUP_RF_DR_LOW_Pos) & 0b1u ){
+		return 250000u;
+	}
+
+	return ((rf_setup >> NRF24_REG_RF_SETUP_RF_DR_HIGH_Pos) & 0b1u) ? 2000000u : 1000000u;
+}
+
+static uint8_t sim_crcBytes( sim_radio_t* r ){
+	uint8_t config = r->reg[NRF24_REG_CONFIG];
+
+	if( ((config >> NRF24_REG_CONFIG_EN_CRC_Pos) & 0b1u) == 0 ){
+		return 0;
+	}
+
+	return ((config >> NRF24_REG_CONFIG_CRCO_Pos) & 0b1u) ? 2 : 1;
+}
+
+static uint8_t sim_dpl( sim_radio_t* r, uint8_t pipe ){
+	return ((r->reg[NRF24_REG_FEATURE] >> NRF24_REG_FEATURE_EN_DPL_Pos) & 0b1u) && ((r->reg[NRF24_REG_DYNPD] >> pipe) & 0b1u);
+}
+
+/*
+ * sim_airtime - Time on air of a packet: preamble, address, 9-bit packet control field, payload, CRC
+ *
+ * sim_radio_t* @r:		sending radio
+ * uint8_t @size:		# of payload bytes
+ *
+ * @return: # of core cycles
+ */
+static uint64_t sim_airtime( sim_radio_t* r, uint8_t size ){
+	uint64_t bits = 8u + 8u * sim_aw( r ) + 9u + 8u * size + 8u * sim_crcBytes( r );
+
+	return (bits * SystemCoreClock) / sim_bitRate( r );
+}
+
+static uint64_t sim_ard( sim_radio_t* r ){
+	return sim_us( 250u * (((r->reg[NRF24_REG_SETUP_RETR] >> NRF24_REG_SETUP_RETR_ARD_Pos) & 0xFu) + 1u) );
+}
+
+static uint16_t sim_checksum( const sim_payload_t* p ){
+	uint16_t sum = p->size;
+	uint8_t i;
+
+	for( i = 0; i < p->size; i++ ){
+		sum = (uint16_t)((sum << 1) ^ (sum >> 15) ^ p->data[i]);
+	}
+
+	return sum;
+}
+
+static uint8_t* sim_addrReg( sim_radio_t* r, uint8_t reg ){
+	switch( reg ){
+		case NRF24_REG_RX_ADDR_P0:	return r->addr[0];
+		case NRF24_REG_RX_ADDR_P1:	return r->addr[1];
+		case NRF24_REG_TX_ADDR:			return r->addr[2];
+		default:										return NULL;
+	}
+}
+
+/*
+ * sim_pipeOf - Pipe of @r whose address matches the TX address of @from
+ *
+ * sim_radio_t* @r:			receiver
+ * sim_radio_t* @from:	sender
+ *
+ * @return: pipe, NRF24_PIPE_COUNT if none
+ */
+static uint8_t sim_pipeOf( sim_radio_t* r, sim_radio_t* from ){
+	uint8_t aw = sim_aw( r );
+	uint8_t* address = from->addr[2];
+	uint8_t pipe;
+
+	for( pipe = 0; pipe < NRF24_PIPE_COUNT; pipe++ ){
+		if( ((r->reg[NRF24_REG_EN_RXADDR] >> pipe) & 0b1u) == 0 ){
+			continue;
+		}
+
+		if( pipe == 0 && memcmp( r->addr[0], address, aw ) == 0 ){
+			return 0;
+		}
+		if( pipe == 1 && memcmp( r->addr[1], address, aw ) == 0 ){
+			return 1;
+		}
+		if( pipe >= 2 && r->reg[NRF24_REG_RX_ADDR_P2 + pipe - 2] == address[0] && memcmp( &r->addr[1][1], &address[1], aw - 1u ) == 0 ){
+			return pipe;
+		}
+	}
+
+	return NRF24_PIPE_COUNT;
+}
+
+static void sim_pushRx( sim_radio_t* r, const uint8_t* data, uint8_t size, uint8_t pipe ){
+	sim_payload_t* slot = &r->rx[r->rx_count++];
+
+	memcpy( slot->data, data, size );
+	slot->size = size;
+	slot->pipe = pipe;
+	r->flags |= SIM_RX_DR;
+}
+
+static void sim_popTx( sim_radio_t* r, uint8_t index ){
+	memmove( &r->tx[index], &r->tx[index + 1], (size_t)(r->tx_count - index - 1) * sizeof(sim_payload_t) );
+	r->tx_count--;
+}
+
+/*
+ * sim_receive - Delivers a packet of @from to @r if it listens on the same channel/rate/address
+ *
+ * sim_radio_t* @r:				receiver
+ * sim_radio_t* @from:		sender
+ * sim_payload_t* @packet:	packet on air
+ * uint64_t @start:				start of the packet on air
+ * sim_payload_t* @ack:		ACK payload sent back, size 0 if none
+ *
+ * @return: TRUE if an ACK goes back
+ */
+static uint8_t sim_receive( sim_radio_t* r, sim_radio_t* from, sim_payload_t* packet, uint64_t start, sim_payload_t* ack ){
+	uint64_t listening;
+	uint8_t pipe, i;
+	uint16_t sum;
+
+	ack->size = 0;
+
+	if( !sim_powered(r) || !sim_isPrx(r) || !r->ce ){
+		return FALSE;
+	}
+
+	// Tstby2a from the latest of CE high, PRIM_RX change, start-up
+	listening = r->ce_rise;
+	if( r->mode_at > listening ){
+		listening = r->mode_at;
+	}
+	if( r->ready_at > listening ){
+		listening = r->ready_at;
+	}
+	if( start < listening + sim_us( NRF24_RX_SETTLING_US ) ){
+		return FALSE;
+	}
+
+	if( r->reg[NRF24_REG_RF_CH] != from->reg[NRF24_REG_RF_CH] || sim_bitRate(r) != sim_bitRate(from)
+		|| sim_aw(r) != sim_aw(from) || sim_crcBytes(r) != sim_crcBytes(from) ){
+		return FALSE;
+	}
+
+	pipe = sim_pipeOf( r, from );
+	if( pipe >= NRF24_PIPE_COUNT ){
+		return FALSE;
+	}
+
+	// Packet control field read with the wrong layout or length: CRC fails
+	if( sim_dpl( r, pipe ) != sim_dpl( from, 0 ) ){
+		return FALSE;
+	}
+	if( !sim_dpl( r, pipe ) && packet->size != (r->reg[NRF24_REG_RX_PW_P0 + pipe] & 0x3Fu) ){
+		return FALSE;
+	}
+
+	if( r->rx_count >= SIM_FIFO_LEVELS ){
+		r->stats.dropped_full++;
+		return FALSE;
+	}
+
+	// A retransmit of the packet received last (its ACK was lost) is ACKed again but not stored
+	sum = sim_checksum( packet );
+	if( r->rx_valid[pipe] && r->rx_pid[pipe] == packet->pid && r->rx_sum[pipe] == sum ){
+		r->stats.duplicates++;
+	} else {
+		r->rx_valid[pipe] = TRUE;
+		r->rx_pid[pipe] = packet->pid;
+		r->rx_sum[pipe] = sum;
+
+		sim_pushRx( r, packet->data, packet->size, pipe );
+		r->stats.received++;
+
+		if( r == &sim_radio[NRF24_SIM_PEER] ){
+			if( sim_peerHook != NULL ){
+				sim_peerHook( pipe, packet->data, packet->size );
+			}
+			if( sim_peerAutoDrain ){
+				memmove( &r->rx[0], &r->rx[1], (size_t)(r->rx_count - 1) * sizeof(sim_payload_t) );
+				r->rx_count--;
+				if( r->rx_count == 0 ){
+					r->flags &= (uint8_t)~SIM_RX_DR;
+				}
+			}
+		}
+	}
+
+	if( packet->noack || ((r->reg[NRF24_REG_EN_AA] >> pipe) & 0b1u) == 0 ){
+		return FALSE;
+	}
+
+	// The first ACK payload queued for the pipe leaves with the ACK
+	if( (r->reg[NRF24_REG_FEATURE] >> NRF24_REG_FEATURE_EN_ACK_PAY_Pos) & 0b1u ){
+		for( i = 0; i < r->tx_count; i++ ){
+			if( r->tx[i].ack && r->tx[i].pipe == pipe ){
+				*ack = r->tx[i];
+				sim_popTx( r, i );
+				r->flags |= SIM_TX_DS;
+				r->stats.ack_payloads++;
+				break;
+			}
+		}
+	}
+
+	r->stats.acks++;
+
+	if( sim_lost( r->ack_loss_permille ) ){
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * sim_evaluate - Starts a transmission if the PTX has everything it needs: PWR_UP, CE high,
+ * a payload and no MAX_RT pending
+ *
+ * sim_radio_t* @r:	radio
+ * uint64_t @now:		current time
+ *
+ * @return: void
+ */
+static void sim_evaluate( sim_radio_t* r, uint64_t now ){
+	uint64_t start = now;
+
+	if( r->state != SIM_IDLE || !sim_powered(r) || sim_isPrx(r) || !r->ce ){
+		return;
+	}
+
+	if( r->tx_count == 0 || (r->flags & SIM_MAX_RT) || r->tx[0].ack ){
+		return;
+	}
+
+	if( now < r->ready_at ){
+		r->stats.early_starts++;
+		start = r->ready_at;
+	}
+
+	r->arc_cnt = 0;
+	r->tx[0].pid = r->pid++;
+	r->state = SIM_TX_SETTLE;
+	r->event_at = start + sim_us( NRF24_RX_SETTLING_US );
+}
+
+/*
+ * sim_event - Ends the current state of @r at its event time
+ *
+ * uint8_t @index:	radio
+ *
+ * @return: void
+ */
+static void sim_event( uint8_t index ){
+	sim_radio_t* r = &sim_radio[index];
+	sim_radio_t* other = &sim_radio[index ^ 1u];
+	uint64_t at = r->event_at;
+	sim_payload_t* packet = &r->tx[0];
+
+	r->event_at = SIM_NO_EVENT;
+
+	switch( r->state ){
+		case SIM_TX_SETTLE:
+			r->state = SIM_TX_AIR;
+			r->event_at = at + sim_airtime( r, packet->size );
+			r->stats.air_packets++;
+			break;
+
+		case SIM_TX_AIR:
+			if( r->drop_next > 0 ){
+				r->drop_next--;
+				r->acked = FALSE;
+			} else if( sim_lost( r->loss_permille ) ){
+				r->acked = FALSE;
+			} else {
+				r->acked = sim_receive( other, r, packet, at - sim_airtime( r, packet->size ), &r->ack_in );
+			}
+
+			// NO_ACK packets and PTX without auto-ack: done once on air
+			if( packet->noack || ((r->reg[NRF24_REG_EN_AA] >> 0) & 0b1u) == 0 ){
+				sim_popTx( r, 0 );
+				r->flags |= SIM_TX_DS;
+				r->stats.tx_ds++;
+				r->state = SIM_IDLE;
+				sim_evaluate( r, at );
+				break;
+			}
+
+			r->state = SIM_ACK_WAIT;
+			if( r->acked ){
+				r->event_at = at + sim_us( NRF24_RX_SETTLING_US ) + sim_airtime( other, r->ack_in.size );
+			} else {
+				r->event_at = at + sim_ard( r );
+			}
+			break;
+
+		case SIM_ACK_WAIT:
+			if( r->acked ){
+				sim_popTx( r, 0 );
+				r->flags |= SIM_TX_DS;
+				r->stats.tx_ds++;
+
+				// ACK payload: RX_DR on pipe #0 together with TX_DS
+				if( r->ack_in.size > 0 && r->rx_count < SIM_FIFO_LEVELS ){
+					sim_pushRx( r, r->ack_in.data, r->ack_in.size, 0 );
+					r->stats.received++;
+				}
+
+				r->state = SIM_IDLE;
+				sim_evaluate( r, at );
+			} else if( r->arc_cnt < ((r->reg[NRF24_REG_SETUP_RETR] >> NRF24_REG_SETUP_RETR_ARC_Pos) & 0xFu) ){
+				// ARD covered the PLL settling, the retransmit goes straight on air
+				r->arc_cnt++;
+				r->state = SIM_TX_AIR;
+				r->event_at = at + sim_airtime( r, packet->size );
+				r->stats.air_packets++;
+			} else {
+				r->flags |= SIM_MAX_RT;
+				r->stats.max_rt++;
+				if( r->plos_cnt < 15u ){
+					r->plos_cnt++;
+				}
+				r->state = SIM_IDLE;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*
+ * sim_writeReg - W_REGISTER on a radio
+ *
+ * sim_radio_t* @r:				radio
+ * uint8_t @reg:					register address
+ * const uint8_t* @data:	value
+ * uint8_t @size:					# of bytes
+ * uint64_t @now:					current time
+ *
+ * @return: void
+ */
+static void sim_writeReg( sim_radio_t* r, uint8_t reg, const uint8_t* data, uint8_t size, uint64_t now ){
+	uint8_t* address = sim_addrReg( r, reg );
+	uint8_t old;
+
+	if( size == 0 ){
+		return;
+	}
+
+	if( address != NULL ){
+		memcpy( address, data, (size < NRF24_ADDR_MAX_WIDTH) ? size : NRF24_ADDR_MAX_WIDTH );
+		return;
+	}
+
+	switch( reg ){
+		case NRF24_REG_STATUS:
+			r->flags &= (uint8_t)~(data[0] & SIM_STATUS_FLAGS);
+			break;
+
+		case NRF24_REG_OBSERVE_TX:
+		case NRF24_REG_RPD:
+		case NRF24_REG_FIFO_STATUS:
+			break;
+
+		case NRF24_REG_CONFIG:
+			old = r->reg[NRF24_REG_CONFIG];
+			r->reg[NRF24_REG_CONFIG] = data[0];
+
+			if( !((old >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u) && sim_powered(r) ){
+				r->ready_at = now + sim_us( NRF24_POWER_UP_US );
+			}
+			if( !sim_powered(r) ){
+				r->state = SIM_IDLE;
+				r->event_at = SIM_NO_EVENT;
+			}
+			if( ((old ^ data[0]) >> NRF24_REG_CONFIG_PRIM_RX_Pos) & 0b1u ){
+				r->mode_at = now;
+			}
+			break;
+
+		case NRF24_REG_RF_CH:
+			r->reg[NRF24_REG_RF_CH] = data[0];
+			r->plos_cnt = 0;
+			break;
+
+		default:
+			if( reg < SIM_REG_COUNT ){
+				r->reg[reg] = data[0];
+			}
+			break;
+	}
+}
+
+/*
+ * sim_readReg - R_REGISTER on a radio
+ *
+ * sim_radio_t* @r:		radio
+ * uint8_t @reg:			register address
+ * uint8_t* @reply:		# of @size bytes
+ * uint8_t @size:			# of bytes
+ * uint64_t @now:			current time
+ *
+ * @return: void
+ */
+static void sim_readReg( sim_radio_t* r, uint8_t reg, uint8_t* reply, uint8_t size, uint64_t now ){
+	uint8_t* address = sim_addrReg( r, reg );
+
+	if( size == 0 ){
+		return;
+	}
+
+	if( address != NULL ){
+		memcpy( reply, address, (size < NRF24_ADDR_MAX_WIDTH) ? size : NRF24_ADDR_MAX_WIDTH );
+		return;
+	}
+
+	switch( reg ){
+		case NRF24_REG_STATUS:
+			reply[0] = nrf24_simRadioStatus( (uint8_t)(r - sim_radio), now );
+			break;
+
+		case NRF24_REG_OBSERVE_TX:
+			reply[0] = (uint8_t)((r->plos_cnt << NRF24_REG_OBSERVE_TX_PLOS_CNT_Pos) | (r->arc_cnt << NRF24_REG_OBSERVE_TX_ARC_CNT_Pos));
+			break;
+
+		case NRF24_REG_RPD:
+			reply[0] = sim_noise[r->reg[NRF24_REG_RF_CH] % NRF24_CHANNEL_COUNT] ? 1u : 0u;
+			break;
+
+		case NRF24_REG_FIFO_STATUS:
+			reply[0] = (uint8_t)(((r->tx_count == SIM_FIFO_LEVELS) << NRF24_REG_FIFO_STATUS_TX_FULL_Pos)
+				| ((r->tx_count == 0) << NRF24_REG_FIFO_STATUS_TX_EMPTY_Pos)
+				| ((r->rx_count == SIM_FIFO_LEVELS) << NRF24_REG_FIFO_STATUS_RX_FULL_Pos)
+				| ((r->rx_count == 0) << NRF24_REG_FIFO_STATUS_RX_EMPTY_Pos));
+			break;
+
+		default:
+			reply[0] = (reg < SIM_REG_COUNT) ? r->reg[reg] : 0u;
+			break;
+	}
+}
+
+
+
+/* --- Simulator APIs --- */
+
+/*
+ * nrf24_simRadioReset - Both radios at their datasheet reset values, air link without loss
+ *
+ * @return: void
+ */
+void nrf24_simRadioReset( void ){
+	static const uint8_t reset[SIM_REG_COUNT] = {
+		0x08, 0x3F, 0x03, 0x03, 0x03, 0x02, 0x0E, 0x0E, 0x00, 0x00, 0x00, 0x00, 0xC3, 0xC4, 0xC5, 0xC6,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	};
+	uint8_t i;
+
+	memset( sim_radio, 0, sizeof(sim_radio) );
+	memset( sim_noise, 0, sizeof(sim_noise) );
+	sim_random = 0x2545F491u;
+	sim_peerHook = NULL;
+	sim_peerAutoDrain = FALSE;
+
+	for( i = 0; i < NRF24_SIM_RADIO_COUNT; i++ ){
+		memcpy( sim_radio[i].reg, reset, sizeof(reset) );
+		memset( sim_radio[i].addr[0], 0xE7, NRF24_ADDR_MAX_WIDTH );
+		memset( sim_radio[i].addr[1], 0xC2, NRF24_ADDR_MAX_WIDTH );
+		memset( sim_radio[i].addr[2], 0xE7, NRF24_ADDR_MAX_WIDTH );
+		sim_radio[i].event_at = SIM_NO_EVENT;
+	}
+}
+
+/*
+ * nrf24_simRadioAdvance - Runs every radio event due up to @now, in time order
+ *
+ * uint64_t @now: current time
+ *
+ * @return: void
+ */
+void nrf24_simRadioAdvance( uint64_t now ){
+	uint8_t i, next;
+
+	for( ;; ){
+		next = NRF24_SIM_RADIO_COUNT;
+		for( i = 0; i < NRF24_SIM_RADIO_COUNT; i++ ){
+			if( sim_radio[i].event_at <= now && (next == NRF24_SIM_RADIO_COUNT || sim_radio[i].event_at < sim_radio[next].event_at) ){
+				next = i;
+			}
+		}
+		if( next == NRF24_SIM_RADIO_COUNT ){
+			return;
+		}
+
+		sim_event( next );
+	}
+}
+
+/*
+ * nrf24_simRadioStatus - STATUS register of a radio: flags, RX_P_NO of the RX FIFO head, TX_FULL
+ *
+ * uint8_t @radio:	NRF24_SIM_xx
+ * uint64_t @now:		current time
+ *
+ * @return: STATUS
+ */
+uint8_t nrf24_simRadioStatus( uint8_t radio, uint64_t now ){
+	sim_radio_t* r = &sim_radio[radio];
+	uint8_t rx_p_no = (r->rx_count > 0) ? r->rx[0].pipe : 0b111u;
+
+	(void)now;
+
+	return (uint8_t)(r->flags | (rx_p_no << NRF24_REG_STATUS_RX_P_NO_Pos) | ((r->tx_count == SIM_FIFO_LEVELS) << NRF24_REG_STATUS_TX_FULL_Pos));
+}
+
+/*
+ * nrf24_simRadioExecute - Executes the command of an SPI frame (STATUS already clocked out)
+ *
+ * uint8_t @radio:				NRF24_SIM_xx
+ * const uint8_t* @frame:	command byte followed by its data bytes
+ * uint8_t* @reply:				@length bytes, reply[0] (STATUS) is left untouched
+ * uint8_t @length:				# of frame bytes (command included)
+ * uint64_t @now:					current time
+ *
+ * @return: void
+ */
+void nrf24_simRadioExecute( uint8_t radio, const uint8_t* frame, uint8_t* reply, uint8_t length, uint64_t now ){
+	sim_radio_t* r = &sim_radio[radio];
+	uint8_t cmd = frame[0];
+	uint8_t size = (uint8_t)(length - 1u);
+	const uint8_t* data = &frame[1];
+	sim_payload_t* slot;
+
+	memset( &reply[1], 0, size );
+
+	if( (cmd & 0xE0u) == R_REGISTER ){
+		sim_readReg( r, cmd & REGISTER_MASK, &reply[1], size, now );
+	} else if( (cmd & 0xE0u) == W_REGISTER ){
+		sim_writeReg( r, cmd & REGISTER_MASK, data, size, now );
+	} else if( cmd == R_RX_PAYLOAD ){
+		if( r->rx_count == 0 ){
+			nrf24_simViolation( "R_RX_PAYLOAD on an empty RX FIFO" );
+		} else {
+			if( size != r->rx[0].size ){
+				nrf24_simViolation( "R_RX_PAYLOAD length differs from the payload width" );
+			}
+			memcpy( &reply[1], r->rx[0].data, (size < r->rx[0].size) ? size : r->rx[0].size );
+			memmove( &r->rx[0], &r->rx[1], (size_t)(r->rx_count - 1) * sizeof(sim_payload_t) );
+			r->rx_count--;
+		}
+	} else if( cmd == R_RX_PL_WID ){
+		if( size > 0 ){
+			reply[1] = (r->rx_count > 0) ? r->rx[0].size : 0u;
+		}
+	} else if( cmd == W_TX_PAYLOAD || cmd == W_TX_PAYLOAD_NOACK || (cmd & 0xF8u) == W_ACK_PAYLOAD ){
+		if( r->tx_count >= SIM_FIFO_LEVELS ){
+			nrf24_simViolation( "payload written to a full TX FIFO" );
+		} else if( size == 0 || size > NRF24_MAX_PAYLOAD_SIZE ){
+			nrf24_simViolation( "payload of an invalid length" );
+		} else {
+			slot = &r->tx[r->tx_count++];
+			memset( slot, 0, sizeof(*slot) );
+			memcpy( slot->data, data, size );
+			slot->size = size;
+			slot->noack = (cmd == W_TX_PAYLOAD_NOACK);
+			slot->ack = ((cmd & 0xF8u) == W_ACK_PAYLOAD);
+			slot->pipe = cmd & 0b111u;
+		}
+	} else if( cmd == FLUSH_TX ){
+		r->tx_count = 0;
+		if( r->state != SIM_IDLE ){
+			r->state = SIM_IDLE;
+			r->event_at = SIM_NO_EVENT;
+		}
+	} else if( cmd == FLUSH_RX ){
+		r->rx_count = 0;
+	} else if( cmd != NOP && cmd != REUSE_TX_PL ){
+		nrf24_simViolation( "unknown command" );
+	}
+
+	sim_evaluate( r, now );
+}
+
+/*
+ * nrf24_simRadioSetCe - CE edge on a radio
+ *
+ * uint8_t @radio:	NRF24_SIM_xx
+ * uint8_t @level:	0/1
+ * uint64_t @now:		current time
+ *
+ * @return: void
+ */
+void nrf24_simRadioSetCe( uint8_t radio, uint8_t level, uint64_t now ){
+	sim_radio_t* r = &sim_radio[radio];
+
+	if( level && !r->ce ){
+		r->ce_rise = now;
+		if( sim_powered(r) && now < r->ready_at ){
+			r->stats.early_starts += sim_isPrx(r);
+		}
+	}
+	r->ce = level;
+
+	sim_evaluate( r, now );
+}
+
+/*
+ * nrf24_simRadioIrq - Level of the IRQ pin of a radio (active low, MASK_xx bits of CONFIG applied)
+ *
+ * uint8_t @radio: NRF24_SIM_xx
+ *
+ * @return: 0 = asserted, 1 = released
+ */
+uint8_t nrf24_simRadioIrq( uint8_t radio ){
+	sim_radio_t* r = &sim_radio[radio];
+
+	return (r->flags & (uint8_t)~r->reg[NRF24_REG_CONFIG] & SIM_STATUS_FLAGS) ? 0u : 1u;
+}
+
+void nrf24_simWriteReg( uint8_t radio, uint8_t reg, const uint8_t* data, uint8_t size ){
+	uint8_t frame[NRF24_MAX_FRAME_SIZE];
+
+	frame[0] = W_REGISTER | (reg & REGISTER_MASK);
+	memcpy( &frame[1], data, size );
+	nrf24_simCommand( radio, frame, NULL, (uint8_t)(size + 1u) );
+}
+
+/*
+ * nrf24_simReadReg - Peeks at the first byte of a register, without side effects
+ *
+ * uint8_t @radio:	NRF24_SIM_xx
+ * uint8_t @reg:		register address
+ *
+ * @return: value
+ */
+uint8_t nrf24_simReadReg( uint8_t radio, uint8_t reg ){
+	uint8_t value;
+
+	sim_readReg( &sim_radio[radio], reg, &value, 1, nrf24_simNow() );
+	return value;
+}
+
+/*
+ * nrf24_simRaise - Sets STATUS flags of a radio as if the events had happened
+ *
+ * uint8_t @radio:	NRF24_SIM_xx
+ * uint8_t @flags:	RX_DR/TX_DS/MAX_RT bits
+ *
+ * @return: void
+ */
+void nrf24_simRaise( uint8_t radio, uint8_t flags ){
+	sim_radio[radio].flags |= flags & SIM_STATUS_FLAGS;
+}
+
+/*
+ * nrf24_simInjectRx - Puts a payload into the RX FIFO of a radio as if it had been received
+ *
+ * uint8_t @radio:				NRF24_SIM_xx
+ * uint8_t @pipe:					pipe it was received on
+ * const uint8_t* @data:	payload
+ * uint8_t @size:					# of bytes (1-32)
+ *
+ * @return: TRUE if stored, FALSE if the RX FIFO is full
+ */
+uint8_t nrf24_simInjectRx( uint8_t radio, uint8_t pipe, const uint8_t* data, uint8_t size ){
+	sim_radio_t* r = &sim_radio[radio];
+
+	if( r->rx_count >= SIM_FIFO_LEVELS ){
+		return FALSE;
+	}
+
+	sim_pushRx( r, data, size, pipe );
+	r->stats.received++;
+	return TRUE;
+}
+
+uint8_t nrf24_simTxLevel( uint8_t radio ){
+	return sim_radio[radio].tx_count;
+}
+
+uint8_t nrf24_simRxLevel( uint8_t radio ){
+	return sim_radio[radio].rx_count;
+}
+
+void nrf24_simGetRadioStats( uint8_t radio, nrf24_sim_radio_stats_t* stats ){
+	*stats = sim_radio[radio].stats;
+}
+
+void nrf24_simLoss( uint8_t radio, uint16_t packet_permille, uint16_t ack_permille ){
+	sim_radio[radio].loss_permille = packet_permille;
+	sim_radio[radio].ack_loss_permille = ack_permille;
+}
+
+void nrf24_simDropNext( uint8_t radio, uint32_t count ){
+	sim_radio[radio].drop_next = count;
+}
+
+void nrf24_simNoise( uint8_t channel, uint8_t busy ){
+	sim_noise[channel] = busy;
+}
+
+void nrf24_simPeerHook( void (*hook)( uint8_t pipe, const uint8_t* data, uint8_t size ) ){
+	sim_peerHook = hook;
+}
+
+void nrf24_simPeerAutoDrain( uint8_t enable ){
+	sim_peerAutoDrain = enable;
+}
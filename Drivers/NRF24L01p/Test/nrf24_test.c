@@ -0,0 +1,235 @@
+/*
+ * Host tests of the NRF24L01 library: case runner and link set-up helpers
+ * See nrf24_test.h
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+static const uint8_t nrf24_testAddress[NRF24_ADDR_MAX_WIDTH] = { 0x31, 0x4E, 0x6F, 0x64, 0x65 };
+
+
+/*
+ * nrf24_testMain - Runs every case (or the ones named on the command line) in a child process
+ *
+ * const nrf24_test_t* @tests:	cases
+ * uint32_t @count:							# of cases
+ * int @argc, char** @argv:			main() arguments
+ *
+ * @return: process exit code, 0 if every case passed
+ */
+int nrf24_testMain( const nrf24_test_t* tests, uint32_t count, int argc, char** argv ){
+	uint32_t i, failed = 0, ran = 0;
+	int arg, selected, status;
+	pid_t child;
+
+	for( i = 0; i < count; i++ ){
+		selected = (argc < 2);
+		for( arg = 1; arg < argc; arg++ ){
+			selected |= (strcmp( argv[arg], tests[i].name ) == 0);
+		}
+		if( !selected ){
+			continue;
+		}
+
+		fflush( stdout );
+		child = fork();
+		if( child == 0 ){
+			nrf24_simReset();
+			tests[i].run();
+			fflush( stdout );
+			_exit( 0 );
+		}
+
+		waitpid( child, &status, 0 );
+		ran++;
+		if( WIFEXITED(status) && WEXITSTATUS(status) == 0 ){
+			printf( "[ OK ] %s\n", tests[i].name );
+		} else {
+			printf( "[FAIL] %s\n", tests[i].name );
+			failed++;
+		}
+	}
+
+	printf( "%u/%u passed\n", ran - failed, ran );
+	return (failed == 0 && ran > 0) ? 0 : 1;
+}
+
+/*
+ * nrf24_testConfig - Configuration of both ends: channel 76 at 2Mbps, 5-byte address, dynamic
+ * payload length with ACK payloads, 15 retransmits 250us apart, every interrupt enabled
+ *
+ * nrf24_config_t* @config:	destination
+ * uint8_t @mode:						@NRF24_REG_CONFIG_PRIM_RX_Val
+ *
+ * @return: void
+ */
+void nrf24_testConfig( nrf24_config_t* config, uint8_t mode ){
+	memset( config, 0, sizeof(*config) );
+
+	config->rx_iqr = NRF24_REG_CONFIG_MASK_xx_Val_IQR_ENABLE;
+	config->tx_iqr = NRF24_REG_CONFIG_MASK_xx_Val_IQR_ENABLE;
+	config->max_rt_iqr = NRF24_REG_CONFIG_MASK_xx_Val_IQR_ENABLE;
+	config->en_crc = NRF24_REG_CONFIG_EN_CRC_Val_ENABLE;
+	config->mode = mode;
+	config->address_width = NRF24_REG_SETUP_AW_Val_5BYTES;
+	config->ard = NRF24_REG_SETUP_RETR_ARD_Func_Val_step250_max4000us( 250 );
+	config->arc = 15;
+	config->rf_chl = 76;
+	config->payload_width = NRF24_MAX_PAYLOAD_SIZE;
+	config->dpl = NRF24_REG_FEATURE_EN_DPL_Val_ENABLE;
+	config->ack_pay = NRF24_REG_FEATURE_EN_ACK_PAY_Val_ENABLE;
+	config->pipes[0].enable = NRF24_REG_EN_RXADDR_ERX_Px_Val_ENABLE;
+	config->pipes[0].auto_ack = NRF24_REG_EN_AA_ENAA_Px_Val_ENABLE;
+	memcpy( config->pipes[0].address, nrf24_testAddress, NRF24_ADDR_MAX_WIDTH );
+	memcpy( config->tx_address, nrf24_testAddress, NRF24_ADDR_MAX_WIDTH );
+	config->rf_pwr = NRF24_REG_RF_SETUP_RF_PWR_Val_0dBm;
+	config->dr_high = NRF24_REG_RF_SETUP_RF_DR_HIGH_Val_2MBPS;
+	config->en_dyn_ack = NRF24_REG_FEATURE_EN_DYN_ACK_Val_ENABLE;
+}
+
+/*
+ * nrf24_testPeer - Sets the peer up as the other end of @config on pipe #0, powered up, CE high if PRX
+ *
+ * const nrf24_config_t* @config:	configuration of the device under test
+ * uint8_t @mode:									peer's @NRF24_REG_CONFIG_PRIM_RX_Val
+ *
+ * @return: void
+ */
+void nrf24_testPeer( const nrf24_config_t* config, uint8_t mode ){
+	uint8_t value;
+
+	nrf24_simSetCe( NRF24_SIM_PEER, 0 );
+
+	value = (uint8_t)((config->en_crc << NRF24_REG_CONFIG_EN_CRC_Pos) | (0b1u << NRF24_REG_CONFIG_PWR_UP_Pos) | (mode << NRF24_REG_CONFIG_PRIM_RX_Pos));
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_CONFIG, &value, 1 );
+	value = (uint8_t)(config->pipes[0].auto_ack << NRF24_REG_EN_AA_ENAA_P0_Pos);
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_EN_AA, &value, 1 );
+	value = 0b1u << NRF24_REG_EN_RXADDR_ERX_P0_Pos;
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_EN_RXADDR, &value, 1 );
+	value = (uint8_t)((config->arc << NRF24_REG_SETUP_RETR_ARC_Pos) | (config->ard << NRF24_REG_SETUP_RETR_ARD_Pos));
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_SETUP_RETR, &value, 1 );
+	value = config->address_width;
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_SETUP_AW, &value, 1 );
+	value = config->rf_chl;
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_RF_CH, &value, 1 );
+	value = (uint8_t)((config->rf_pwr << NRF24_REG_RF_SETUP_RF_PWR_Pos) | (config->dr_high << NRF24_REG_RF_SETUP_RF_DR_HIGH_Pos) | (config->dr_low << NRF24_REG_RF_SETUP_RF_DR_LOW_Pos));
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_RF_SETUP, &value, 1 );
+	value = config->payload_width;
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_RX_PW_P0, &value, 1 );
+	value = (uint8_t)((config->en_dyn_ack << NRF24_REG_FEATURE_EN_DYN_ACK_Pos) | (config->ack_pay << NRF24_REG_FEATURE_EN_ACK_PAY_Pos) | (config->dpl << NRF24_REG_FEATURE_EN_DPL_Pos));
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_FEATURE, &value, 1 );
+	value = config->dpl ? (uint8_t)(config->pipes[0].auto_ack << NRF24_REG_DYNPD_DPL_P0_Pos) : 0u;
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_DYNPD, &value, 1 );
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_RX_ADDR_P0, config->tx_address, NRF24_ADDR_MAX_WIDTH );
+	nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_TX_ADDR, config->tx_address, NRF24_ADDR_MAX_WIDTH );
+
+	if( mode == NRF24_REG_CONFIG_PRIM_RX_Val_PRX ){
+		nrf24_simSetCe( NRF24_SIM_PEER, 1 );
+	}
+}
+
+/*
+ * nrf24_testStart - Peer as the other end of @config, nrf24_Init, then both chips through their start-up
+ *
+ * nrf24_config_t* @config: configuration of the device under test
+ *
+ * @return: void
+ */
+void nrf24_testStart( nrf24_config_t* config ){
+	nrf24_testPeer( config, config->mode ? NRF24_REG_CONFIG_PRIM_RX_Val_PTX : NRF24_REG_CONFIG_PRIM_RX_Val_PRX );
+
+	NRF24_CHECK_EQ( nrf24_Init( config ), NRF24_OK );
+	nrf24_simRunUs( NRF24_POWER_UP_US + NRF24_RX_SETTLING_US );
+}
+
+/*
+ * nrf24_testPeerReceive - Pops a payload from the peer's RX FIFO
+ *
+ * uint8_t* @data:	NRF24_MAX_PAYLOAD_SIZE bytes
+ * uint8_t* @size:	# of bytes received
+ * uint8_t* @pipe:	pipe it was received on (NULL = not needed)
+ *
+ * @return: TRUE if a payload was there
+ */
+uint8_t nrf24_testPeerReceive( uint8_t* data, uint8_t* size, uint8_t* pipe ){
+	uint8_t frame[NRF24_MAX_FRAME_SIZE] = { R_RX_PL_WID, NOP };
+	uint8_t reply[NRF24_MAX_FRAME_SIZE];
+	uint8_t clear = 0b1u << NRF24_REG_STATUS_RX_DR_Pos;
+
+	if( nrf24_simRxLevel( NRF24_SIM_PEER ) == 0 ){
+		return FALSE;
+	}
+
+	nrf24_simCommand( NRF24_SIM_PEER, frame, reply, 2 );
+	*size = reply[1];
+	if( pipe != NULL ){
+		*pipe = (reply[0] >> NRF24_REG_STATUS_RX_P_NO_Pos) & NRF24_REG_STATUS_RX_P_NO_Msk;
+	}
+
+	memset( frame, NOP, sizeof(frame) );
+	frame[0] = R_RX_PAYLOAD;
+	nrf24_simCommand( NRF24_SIM_PEER, frame, reply, (uint8_t)(*size + 1u) );
+	memcpy( data, &reply[1], *size );
+
+	if( nrf24_simRxLevel( NRF24_SIM_PEER ) == 0 ){
+		nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_STATUS, &clear, 1 );
+	}
+
+	return TRUE;
+}
+
+/*
+ * nrf24_testPeerSend - Queues a payload on the peer (PTX) and pulses CE to send it
+ *
+ * const uint8_t* @data:	payload
+ * uint8_t @size:					# of bytes
+ *
+ * @return: void
+ */
+void nrf24_testPeerSend( const uint8_t* data, uint8_t size ){
+	uint8_t frame[NRF24_MAX_FRAME_SIZE];
+
+	frame[0] = W_TX_PAYLOAD;
+	memcpy( &frame[1], data, size );
+	nrf24_simCommand( NRF24_SIM_PEER, frame, NULL, (uint8_t)(size + 1u) );
+
+	nrf24_simSetCe( NRF24_SIM_PEER, 1 );
+	nrf24_simRunUs( 15 );
+	nrf24_simSetCe( NRF24_SIM_PEER, 0 );
+}
+
+/*
+ * nrf24_testPeerAckPayload - Queues a payload on the peer (PRX) for the next ACK on @pipe
+ *
+ * uint8_t @pipe:					pipe
+ * const uint8_t* @data:	payload
+ * uint8_t @size:					# of bytes
+ *
+ * @return: void
+ */
+void nrf24_testPeerAckPayload( uint8_t pipe, const uint8_t* data, uint8_t size ){
+	uint8_t frame[NRF24_MAX_FRAME_SIZE];
+
+	frame[0] = (uint8_t)(W_ACK_PAYLOAD | pipe);
+	memcpy( &frame[1], data, size );
+	nrf24_simCommand( NRF24_SIM_PEER, frame, NULL, (uint8_t)(size + 1u) );
+}
+
+static uint8_t nrf24_testIdle( void ){
+	return !nrf24_txPending() && !nrf24_isBusy() && nrf24_simTxLevel( NRF24_SIM_DUT ) == 0;
+}
+
+/*
+ * nrf24_testWaitIdle - Runs the simulation until every queued payload left the device under test
+ *
+ * @return: TRUE, FALSE on timeout
+ */
+uint8_t nrf24_testWaitIdle( void ){
+	return nrf24_simRunUntil( nrf24_testIdle, NRF24_TEST_TIMEOUT_US );
+}
@@ -0,0 +1,51 @@
+#ifndef NRF24L01P_TEST_NRF24_TEST_H_
+#define NRF24L01P_TEST_NRF24_TEST_H_
+
+/*
+ * Host tests of the NRF24L01 library
+ * Every case runs in its own process (the driver keeps its state in statics) against a freshly
+ * reset simulator: the device under test is driven through the driver, the peer through
+ * nrf24_testPeerxx and the nrf24_simxx calls.
+ */
+
+#include "nrf24_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/* Test case */
+typedef struct {
+  const char* name;
+  void (*run)( void );
+} nrf24_test_t;
+
+/* Fails the running case with the expression and its location */
+#define NRF24_CHECK(expr) do { \
+    if( !(expr) ){ \
+      printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr ); \
+      exit( 1 ); \
+    } \
+  } while( 0 )
+
+#define NRF24_CHECK_EQ(a, b) do { \
+    long long nrf24_a_ = (long long)(a), nrf24_b_ = (long long)(b); \
+    if( nrf24_a_ != nrf24_b_ ){ \
+      printf( "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, nrf24_a_, nrf24_b_ ); \
+      exit( 1 ); \
+    } \
+  } while( 0 )
+
+/* Longest wait of the nrf24_testWaitxx helpers, in us */
+#define NRF24_TEST_TIMEOUT_US   100000
+
+int nrf24_testMain( const nrf24_test_t* tests, uint32_t count, int argc, char** argv );
+
+void nrf24_testConfig( nrf24_config_t* config, uint8_t mode );
+void nrf24_testPeer( const nrf24_config_t* config, uint8_t mode );
+void nrf24_testStart( nrf24_config_t* config );
+uint8_t nrf24_testPeerReceive( uint8_t* data, uint8_t* size, uint8_t* pipe );
+void nrf24_testPeerSend( const uint8_t* data, uint8_t size );
+void nrf24_testPeerAckPayload( uint8_t pipe, const uint8_t* data, uint8_t size );
+uint8_t nrf24_testWaitIdle( void );
+
+#endif // NRF24L01P_TEST_NRF24_TEST_H_
@@ -0,0 +1,206 @@
+/*
+ * Host tests of the NRF24L01 library: nrf24_benchRun against the simulated peer, at every data rate
+ * The CSV lines are the same as on the board (nrf24_benchPrint), in simulated time and the
+ * simulator's cost model; the checks only hold the results to what the link can physically do.
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include "nrf24l01p_bench.h"
+#include <string.h>
+
+
+#define TEST_PACKETS    50
+#define TEST_REQUESTS   32
+
+// Responder's MCU from the request on air to its reply queued: RX_DR serviced, ACK sent, request read, role switched
+#define TEST_RESPONDER_US   250
+
+static const uint8_t test_sizes[] = { 1, 16, NRF24_MAX_PAYLOAD_SIZE };
+
+/* Simulated nrf24_benchResponder */
+static uint64_t test_replyAt;     // 0 = no reply due
+static uint8_t test_replySeq;
+static uint8_t test_replying;
+
+/*
+ * test_benchRate - Sets the peer up as PRX at @data_rate and runs the benchmark for each of test_sizes
+ *
+ * uint8_t @data_rate: @NRF24_BENCH_DR_xx
+ *
+ * @return: void
+ */
+static void test_benchRate( uint8_t data_rate ){
+	nrf24_config_t config;
+	nrf24_bench_result_t result;
+	nrf24_sim_stats_t stats;
+	uint32_t pps = 0;
+	uint8_t i;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	config.dr_high = (data_rate == NRF24_BENCH_DR_2MBPS) ? 0b1u : 0b0u;
+	config.dr_low = (data_rate == NRF24_BENCH_DR_250KBPS) ? NRF24_REG_RF_SETUP_RF_DR_LOW_Val_SET : NRF24_REG_RF_SETUP_RF_DR_LOW_Val_RESET;
+	// The ACK of a 250kbps link does not come back within 250us
+	if( data_rate == NRF24_BENCH_DR_250KBPS ){
+		config.ard = NRF24_REG_SETUP_RETR_ARD_Func_Val_step250_max4000us( 750 );
+	}
+	nrf24_testPeer( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PRX );
+	nrf24_simPeerAutoDrain( TRUE );
+
+	nrf24_benchPrintHeader();
+	for( i = 0; i < sizeof(test_sizes); i++ ){
+		NRF24_CHECK_EQ( nrf24_benchRun( &config, data_rate, test_sizes[i], TEST_PACKETS, &result ), NRF24_OK );
+		nrf24_benchPrint( &result );
+
+		NRF24_CHECK_EQ( result.sent, TEST_PACKETS );
+		NRF24_CHECK_EQ( result.acked, TEST_PACKETS );
+		NRF24_CHECK_EQ( result.lost, 0 );
+		NRF24_CHECK( result.init_us > 0 && result.init_frames > 0 );
+		// Same register writes either way, the batch adds the CONFIG read and STATUS clear
+		NRF24_CHECK( result.init_reg_frames > 0 && result.init_frames > result.init_reg_frames );
+		NRF24_CHECK( result.init_reg_us > 0 );
+		NRF24_CHECK( result.submit_cycles > 0 && result.irq_cycles > 0 );
+		NRF24_CHECK( result.spi_load_permille > 0 && result.spi_load_permille < 1000 );
+		NRF24_CHECK( result.rtt_p50_us > 0 && result.rtt_p50_us <= result.rtt_max_us );
+		NRF24_CHECK( result.to_prx_us > 0 );
+
+		// Longer payloads take longer on air
+		NRF24_CHECK( i == 0 || result.pps < pps );
+		pps = result.pps;
+	}
+
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.violations, 0 );
+}
+
+/* Register access cost of the transport: at least the 2 bytes on the wire, the rest is driver/HAL overhead */
+static void test_commands( void ){
+	nrf24_config_t config;
+	nrf24_bench_cmd_result_t result;
+	uint32_t wire = (uint32_t)nrf24_simUsToCycles( 1000 ) * 2u * 8u / 5250u;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+
+	NRF24_CHECK_EQ( nrf24_benchCommands( &result ), NRF24_OK );
+	nrf24_benchPrintCommands( &result );
+
+	NRF24_CHECK_EQ( result.transport, NRF24_SPI_TRANSPORT );
+	NRF24_CHECK( result.write_reg_min >= wire && result.write_reg_mean >= result.write_reg_min );
+	NRF24_CHECK( result.read_reg_min >= wire && result.read_reg_mean >= result.read_reg_min );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_RF_CH ), 76 );
+
+	// The BSRR store costs nothing in the simulator's model, the HAL call does
+	NRF24_CHECK( result.nss_bsrr_cycles < result.nss_hal_cycles );
+	NRF24_CHECK( nrf24_simGpio( 2 )->ODR & NRF24_NSS_PIN );
+}
+
+/*
+ * test_responderHook - Peer hook: a NRF24_BENCH_MSG_REPLY request is answered once the responder's MCU got to it
+ */
+static void test_responderHook( uint8_t pipe, const uint8_t* data, uint8_t size ){
+	if( pipe == 0 && size >= NRF24_BENCH_REQUEST_SIZE && data[0] == NRF24_BENCH_MSG_REPLY ){
+		test_replyAt = nrf24_simNow() + nrf24_simUsToCycles( TEST_RESPONDER_US );
+		test_replySeq = data[1];
+	}
+}
+
+/*
+ * test_responderTask - Peer task, what nrf24_benchResponder does on the board: keeps an answer
+ * preloaded as ACK payload in PRX, sends a due reply as PTX and goes back to PRX once it is ACKed
+ *
+ * @return: void
+ */
+static void test_responderTask( void ){
+	uint8_t answer[NRF24_BENCH_REPLY_SIZE] = { NRF24_BENCH_MSG_ACK };
+	uint8_t flush = FLUSH_TX;
+	uint8_t flags = (0b1u << NRF24_REG_STATUS_TX_DS_Pos) | (0b1u << NRF24_REG_STATUS_MAX_RT_Pos);
+	uint8_t config = nrf24_simReadReg( NRF24_SIM_PEER, NRF24_REG_CONFIG );
+
+	if( test_replying ){
+		if( (nrf24_simReadReg( NRF24_SIM_PEER, NRF24_REG_STATUS ) & flags) == 0 ){
+			return;
+		}
+
+		nrf24_simSetCe( NRF24_SIM_PEER, 0 );
+		nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_STATUS, &flags, 1 );
+		nrf24_simCommand( NRF24_SIM_PEER, &flush, NULL, 1 );
+		config |= (uint8_t)(0b1u << NRF24_REG_CONFIG_PRIM_RX_Pos);
+		nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_CONFIG, &config, 1 );
+		nrf24_simSetCe( NRF24_SIM_PEER, 1 );
+		test_replying = FALSE;
+		return;
+	}
+
+	if( test_replyAt != 0 && nrf24_simNow() >= test_replyAt ){
+		test_replyAt = 0;
+		test_replying = TRUE;
+
+		nrf24_simSetCe( NRF24_SIM_PEER, 0 );
+		nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_STATUS, &flags, 1 );
+		nrf24_simCommand( NRF24_SIM_PEER, &flush, NULL, 1 );
+		config &= (uint8_t)~(0b1u << NRF24_REG_CONFIG_PRIM_RX_Pos);
+		nrf24_simWriteReg( NRF24_SIM_PEER, NRF24_REG_CONFIG, &config, 1 );
+
+		answer[0] = NRF24_BENCH_MSG_REPLY;
+		answer[1] = test_replySeq;
+		nrf24_testPeerSend( answer, NRF24_BENCH_REPLY_SIZE );
+		return;
+	}
+
+	if( nrf24_simTxLevel( NRF24_SIM_PEER ) == 0 ){
+		nrf24_testPeerAckPayload( 0, answer, NRF24_BENCH_REPLY_SIZE );
+	}
+}
+
+/* Request/response against the simulated responder: the ACK payload saves the second exchange and both turnarounds */
+static void test_requests( void ){
+	nrf24_config_t config;
+	nrf24_bench_req_result_t result;
+	nrf24_sim_stats_t stats;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testPeer( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PRX );
+	nrf24_simPeerAutoDrain( TRUE );
+	nrf24_simPeerHook( test_responderHook );
+	nrf24_simPeerTask( test_responderTask );
+
+	NRF24_CHECK_EQ( nrf24_benchRequests( &config, TEST_REQUESTS, &result ), NRF24_OK );
+	nrf24_benchPrintRequests( &result );
+
+	NRF24_CHECK_EQ( result.requests, TEST_REQUESTS );
+	NRF24_CHECK_EQ( result.ack_replies, TEST_REQUESTS );
+	NRF24_CHECK_EQ( result.role_replies, TEST_REQUESTS );
+	NRF24_CHECK( result.ack_rtt_p50_us > 0 && result.ack_rtt_p50_us <= result.ack_rtt_max_us );
+	NRF24_CHECK( result.role_rtt_p50_us <= result.role_rtt_max_us );
+	NRF24_CHECK( result.ack_rtt_max_us < result.role_rtt_p50_us );
+
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.violations, 0 );
+}
+
+static void test_bench2m( void ){
+	test_benchRate( NRF24_BENCH_DR_2MBPS );
+}
+
+static void test_bench1m( void ){
+	test_benchRate( NRF24_BENCH_DR_1MBPS );
+}
+
+static void test_bench250k( void ){
+	test_benchRate( NRF24_BENCH_DR_250KBPS );
+}
+
+
+static const nrf24_test_t tests[] = {
+	{ "commands", test_commands },
+	{ "bench_2m", test_bench2m },
+	{ "bench_1m", test_bench1m },
+	{ "bench_250k", test_bench250k },
+	{ "requests", test_requests },
+};
+
+int main( int argc, char** argv ){
+	return nrf24_testMain( tests, sizeof(tests) / sizeof(tests[0]), argc, argv );
+}
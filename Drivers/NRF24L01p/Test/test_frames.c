@@ -0,0 +1,223 @@
+/*
+ * Host tests of the NRF24L01 library: one full-duplex SPI frame per command, STATUS captured
+ * from it, and argument checks that reject a command before anything is copied or sent
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include <string.h>
+
+
+static uint32_t test_frames;
+static uint64_t test_start;
+
+static uint32_t test_callbacks;
+static nrf24_err_t test_callbackErr;
+static uint8_t test_callbackStatus;
+
+static void test_onDone( nrf24_err_t err, uint8_t status ){
+	test_callbacks++;
+	test_callbackErr = err;
+	test_callbackStatus = status;
+}
+
+static uint8_t test_queueIdle( void ){
+	return !nrf24_isBusy() && nrf24_cmdPending() == 0;
+}
+
+static void test_begin( void ){
+	test_frames = nrf24_simFrameCount();
+	test_start = nrf24_simNow();
+}
+
+/*
+ * test_end - Checks and prints the frames issued since test_begin
+ *
+ * const char* @what:		operation
+ * uint8_t @length:			expected length of the single frame (command byte included)
+ *
+ * @return: void
+ */
+static void test_end( const char* what, uint8_t length ){
+	uint32_t frames = nrf24_simFrameCount() - test_frames;
+
+	printf( "%-24s frames %u bytes %u cycles %llu\n", what, frames, length, (unsigned long long)(nrf24_simNow() - test_start) );
+	NRF24_CHECK_EQ( frames, 1 );
+	NRF24_CHECK_EQ( nrf24_simFrame( test_frames )->length, length );
+}
+
+static void test_initDut( void ){
+	nrf24_config_t config;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+}
+
+
+/* Every register access and command is a single frame, its STATUS byte is kept */
+static void test_singleFrame( void ){
+	uint8_t address[NRF24_ADDR_MAX_WIDTH] = { 1, 2, 3, 4, 5 };
+	uint8_t buffer[NRF24_ADDR_MAX_WIDTH];
+	uint8_t value = 40, status;
+
+	test_initDut();
+
+	test_begin();
+	NRF24_CHECK_EQ( nrf24_readReg( NRF24_REG_RF_CH, &value, 1 ), NRF24_OK );
+	test_end( "nrf24_readReg(1)", 2 );
+	NRF24_CHECK_EQ( value, 76 );
+	NRF24_CHECK_EQ( nrf24_getLastStatus(), nrf24_simRadioStatus( NRF24_SIM_DUT, nrf24_simNow() ) );
+
+	test_begin();
+	NRF24_CHECK_EQ( nrf24_writeReg( NRF24_REG_TX_ADDR, address, sizeof(address) ), NRF24_OK );
+	test_end( "nrf24_writeReg(5)", 6 );
+
+	test_begin();
+	NRF24_CHECK_EQ( nrf24_readReg( NRF24_REG_TX_ADDR, buffer, sizeof(buffer) ), NRF24_OK );
+	test_end( "nrf24_readReg(5)", 6 );
+	NRF24_CHECK( memcmp( buffer, address, sizeof(address) ) == 0 );
+
+	test_begin();
+	NRF24_CHECK_EQ( nrf24_sendStandaloneCmd( FLUSH_RX ), NRF24_OK );
+	test_end( "nrf24_sendStandaloneCmd", 1 );
+
+	test_begin();
+	NRF24_CHECK_EQ( nrf24_getStatus( &status ), NRF24_OK );
+	test_end( "nrf24_getStatus", 1 );
+	NRF24_CHECK_EQ( status, nrf24_simRadioStatus( NRF24_SIM_DUT, nrf24_simNow() ) );
+	NRF24_CHECK_EQ( (status >> NRF24_REG_STATUS_RX_P_NO_Pos) & NRF24_REG_STATUS_RX_P_NO_Msk, NRF24_REG_STATUS_RX_P_NO_Val_RX_EMPTY );
+}
+
+/* Out-of-range sizes and pipes fail with NRF24_ERR_PARAM, no frame reaches the chip */
+static void test_paramChecks( void ){
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE + 8];
+	uint8_t size;
+	uint32_t frames;
+	nrf24_batch_t batch;
+	nrf24_sim_stats_t stats;
+
+	test_initDut();
+	memset( data, 0x55, sizeof(data) );
+	frames = nrf24_simFrameCount();
+
+	NRF24_CHECK_EQ( nrf24_writeReg( NRF24_REG_TX_ADDR, data, NRF24_MAX_PAYLOAD_SIZE + 1 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_readReg( NRF24_REG_TX_ADDR, data, NRF24_MAX_PAYLOAD_SIZE + 1 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_submitCmd( W_TX_PAYLOAD, data, NULL, NRF24_MAX_PAYLOAD_SIZE + 1, NULL ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_writeRegAsync( NRF24_REG_TX_ADDR, data, NRF24_MAX_PAYLOAD_SIZE + 1, NULL ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_readRegAsync( NRF24_REG_TX_ADDR, data, NRF24_MAX_PAYLOAD_SIZE + 1, NULL ), NRF24_ERR_PARAM );
+
+	nrf24_batchInit( &batch );
+	NRF24_CHECK_EQ( nrf24_batchCmd( &batch, W_TX_PAYLOAD, data, NRF24_MAX_PAYLOAD_SIZE + 1 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( batch.length, 0 );
+	NRF24_CHECK_EQ( batch.count, 0 );
+
+	NRF24_CHECK_EQ( nrf24_transmit( data, 0 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_transmit( data, NRF24_MAX_PAYLOAD_SIZE + 1 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_txPending(), 0 );
+
+	NRF24_CHECK_EQ( nrf24_writeAckPayload( NRF24_PIPE_COUNT, data, 4 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_writeAckPayload( 0, data, NRF24_MAX_PAYLOAD_SIZE + 1 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_receiveFromPipe( NRF24_PIPE_COUNT, data, &size ), NRF24_ERR_PARAM );
+
+	nrf24_simRunUs( 100 );
+	NRF24_CHECK_EQ( nrf24_simFrameCount(), frames );
+	NRF24_CHECK( !nrf24_isBusy() );
+
+	// The bus is still usable
+	NRF24_CHECK_EQ( nrf24_readReg( NRF24_REG_RF_CH, data, 1 ), NRF24_OK );
+	NRF24_CHECK_EQ( data[0], 76 );
+
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.violations, 0 );
+}
+
+/* Index and size guards return early and are logged as NRF24_FAULT_ASSERT */
+static void test_guardsLogged( void ){
+	nrf24_config_t config, bad;
+	nrf24_rx_stats_t rx_stats = { 7, 7 };
+	uint8_t occupancy[NRF24_CHANNEL_COUNT] = { 0 };
+	uint8_t written = 1;
+	uint32_t faults, frames;
+
+	test_initDut();
+	faults = nrf24_getFaultCount( NRF24_FAULT_ASSERT );
+	frames = nrf24_simFrameCount();
+
+	NRF24_CHECK_EQ( nrf24_rxAvailableOnPipe( NRF24_PIPE_COUNT ), 0 );
+	nrf24_getRxStats( NRF24_PIPE_COUNT, &rx_stats );
+	NRF24_CHECK_EQ( rx_stats.overflows, 7 );
+	NRF24_CHECK_EQ( nrf24_quietestChannel( occupancy, 10, NRF24_CHANNEL_COUNT ), NRF24_CHANNEL_COUNT );
+	NRF24_CHECK_EQ( nrf24_getFaultCount( NRF24_FAULT_COUNT ), 0 );
+	NRF24_CHECK_EQ( nrf24_getFaultCount( NRF24_FAULT_ASSERT ), faults + 4 );
+
+	// Address width used as a copy size
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	config.address_width = 7;
+	NRF24_CHECK_EQ( nrf24_Init( &config ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_setRole( NRF24_REG_CONFIG_PRIM_RX_Val_PRX, &config ), NRF24_ERR_PARAM );
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	bad = config;
+	bad.dpl = NRF24_REG_FEATURE_EN_DPL_Val_DISABLE;
+	bad.ack_pay = NRF24_REG_FEATURE_EN_ACK_PAY_Val_DISABLE;
+	bad.payload_width = NRF24_MAX_PAYLOAD_SIZE + 1;
+	NRF24_CHECK_EQ( nrf24_Reconfigure( &config, &bad, &written ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( written, 0 );
+
+	NRF24_CHECK_EQ( nrf24_simFrameCount(), frames );
+	NRF24_CHECK_EQ( nrf24_getFaultCount( NRF24_FAULT_ASSERT ), faults + 7 );
+}
+
+/* Asynchronous commands report how they ended: STATUS on success, the error otherwise */
+static void test_callbackErrors( void ){
+	uint8_t value = 0;
+
+	test_initDut();
+
+	NRF24_CHECK_EQ( nrf24_submitCmd( R_REGISTER | NRF24_REG_RF_CH, NULL, &value, 1, test_onDone ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_queueIdle, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK_EQ( test_callbacks, 1 );
+	NRF24_CHECK_EQ( test_callbackErr, NRF24_OK );
+	NRF24_CHECK_EQ( test_callbackStatus, nrf24_getLastStatus() );
+	NRF24_CHECK_EQ( value, 76 );
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	// Queued command whose DMA transfer could not start
+	nrf24_simFailDmaStart( 0, 1 );
+	NRF24_CHECK_EQ( nrf24_submitCmd( R_REGISTER | NRF24_REG_RF_CH, NULL, &value, 1, test_onDone ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_queueIdle, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK_EQ( test_callbacks, 2 );
+	NRF24_CHECK_EQ( test_callbackErr, NRF24_ERR_SPI );
+
+	// Transfer failed on the way (HAL_SPI_ErrorCallback)
+	nrf24_simFailDmaTransfer( 0, 1 );
+	NRF24_CHECK_EQ( nrf24_writeRegAsync( NRF24_REG_RF_CH, &value, 1, test_onDone ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_queueIdle, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK_EQ( test_callbacks, 3 );
+	NRF24_CHECK_EQ( test_callbackErr, NRF24_ERR_SPI );
+	NRF24_CHECK_EQ( test_callbackStatus, 0 );
+#else
+	// Executed in place: the error is returned and the callback is not invoked
+	nrf24_simFailSpi( 0, 1, HAL_ERROR );
+	NRF24_CHECK_EQ( nrf24_submitCmd( R_REGISTER | NRF24_REG_RF_CH, NULL, &value, 1, test_onDone ), NRF24_ERR_SPI );
+	NRF24_CHECK_EQ( test_callbacks, 1 );
+#endif
+
+	// The queue keeps running after a failure
+	NRF24_CHECK_EQ( nrf24_submitCmd( R_REGISTER | NRF24_REG_RF_CH, NULL, &value, 1, test_onDone ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_queueIdle, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK_EQ( test_callbackErr, NRF24_OK );
+}
+
+
+static const nrf24_test_t tests[] = {
+	{ "single_frame", test_singleFrame },
+	{ "param_checks", test_paramChecks },
+	{ "guards_logged", test_guardsLogged },
+	{ "callback_errors", test_callbackErrors },
+};
+
+int main( int argc, char** argv ){
+	return nrf24_testMain( tests, sizeof(tests) / sizeof(tests[0]), argc, argv );
+}
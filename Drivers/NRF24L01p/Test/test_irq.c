@@ -0,0 +1,183 @@
+/*
+ * Host tests of the NRF24L01 library: nrf24_irqHandler event order, flags raised while it runs
+ * and recovery from a failed STATUS frame
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include <string.h>
+
+
+#define TEST_TX_DS    (0b1u << NRF24_REG_STATUS_TX_DS_Pos)
+#define TEST_MAX_RT   (0b1u << NRF24_REG_STATUS_MAX_RT_Pos)
+
+// Events in the order they were dispatched: 'r'x_ready, 't'x_done, 'm'ax_rt
+static char test_events[16];
+static uint32_t test_eventCount;
+static uint8_t test_ackInRing;
+static uint8_t test_raised;
+
+static void test_event( char event ){
+	if( test_eventCount < sizeof(test_events) - 1 ){
+		test_events[test_eventCount++] = event;
+	}
+}
+
+static void test_onRxReady( uint8_t pipe ){
+	test_event( 'r' );
+}
+
+static void test_onTxDone( void ){
+	test_ackInRing = (uint8_t)nrf24_rxAvailableOnPipe( 0 );
+	test_event( 't' );
+}
+
+static void test_onMaxRt( void ){
+	test_event( 'm' );
+}
+
+static nrf24_event_callbacks_t test_callbacks = { test_onRxReady, test_onTxDone, test_onMaxRt };
+
+static void test_initDut( void ){
+	nrf24_config_t config;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+}
+
+/* TX_DS comes up in the middle of the handler's first frame, after STATUS went out */
+static void test_raiseTxDs( uint8_t cmd ){
+	if( !test_raised && nrf24_simInIsr() ){
+		test_raised = TRUE;
+		nrf24_simRaise( NRF24_SIM_DUT, TEST_TX_DS );
+	}
+}
+
+
+/* An ACK payload is in the pipe #0 ring, and signalled, before tx_done runs */
+static void test_ackBeforeTxDone( void ){
+	uint8_t reply[6] = { 6, 5, 4, 3, 2, 1 };
+	uint8_t payload[8] = { 0 };
+
+	test_initDut();
+	nrf24_testPeerAckPayload( 0, reply, sizeof(reply) );
+
+	NRF24_CHECK_EQ( nrf24_transmit( payload, sizeof(payload) ), NRF24_OK );
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	nrf24_simRunUs( 1000 );
+
+	NRF24_CHECK( strcmp( test_events, "rt" ) == 0 );
+	NRF24_CHECK_EQ( test_ackInRing, 1 );
+}
+
+/* A flag raised between the STATUS read and its clear is neither cleared nor lost */
+static void test_flagDuringHandler( void ){
+	nrf24_sim_stats_t stats;
+
+	test_initDut();
+	nrf24_simFrameHook( test_raiseTxDs );
+
+	nrf24_simRaise( NRF24_SIM_DUT, TEST_MAX_RT );
+	nrf24_simRunUs( 1000 );
+
+	NRF24_CHECK( test_raised );
+	NRF24_CHECK( strcmp( test_events, "mt" ) == 0 );
+	NRF24_CHECK( nrf24_simRadioIrq( NRF24_SIM_DUT ) );
+
+	// Both served by the same handler run: the line never went high in between
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.exti_runs, 1 );
+}
+
+/* A failed STATUS frame dispatches nothing and is retried from nrf24_tick */
+static void test_statusFailure( void ){
+	test_initDut();
+
+	nrf24_simFailSpi( 0, 1, HAL_ERROR );
+	nrf24_simRaise( NRF24_SIM_DUT, TEST_MAX_RT );
+	nrf24_simRunUs( 50 );
+
+	NRF24_CHECK_EQ( test_eventCount, 0 );
+	NRF24_CHECK( !nrf24_simRadioIrq( NRF24_SIM_DUT ) );
+
+	nrf24_simRunUs( 2000 );
+	NRF24_CHECK( strcmp( test_events, "m" ) == 0 );
+	NRF24_CHECK( nrf24_simRadioIrq( NRF24_SIM_DUT ) );
+	NRF24_CHECK_EQ( nrf24_getFaultCount( NRF24_FAULT_SPI ), 1 );
+}
+
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+static uint32_t test_releasedDuring;
+
+/* Thread context sees an IRQ payload frame still on the bus: the handler has returned */
+static uint8_t test_payloadInFlight( void ){
+	const nrf24_sim_frame_t* frame;
+
+	if( nrf24_simFrameCount() > 0 && !nrf24_simInIsr() && nrf24_simDmaBusy() ){
+		frame = nrf24_simFrame( nrf24_simFrameCount() - 1 );
+		if( frame->isr && (frame->cmd == R_RX_PAYLOAD || frame->cmd == W_TX_PAYLOAD) ){
+			test_releasedDuring |= 0b1u << (frame->cmd == R_RX_PAYLOAD);
+		}
+	}
+
+	return test_releasedDuring == 0b11u;
+}
+
+/* The handler's RX and TX payload frames are DMA transfers and the CPU runs other code meanwhile */
+static void test_payloadDma( void ){
+	uint8_t reply[NRF24_MAX_PAYLOAD_SIZE], payload[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size, pipe, i;
+	const nrf24_sim_frame_t* frame;
+	nrf24_sim_stats_t stats;
+
+	test_initDut();
+	memset( reply, 0x5A, sizeof(reply) );
+	memset( payload, 0xA5, sizeof(payload) );
+
+	for( i = 0; i < 3; i++ ){
+		nrf24_testPeerAckPayload( 0, reply, sizeof(reply) );
+		NRF24_CHECK_EQ( nrf24_transmit( payload, sizeof(payload) ), NRF24_OK );
+	}
+
+	NRF24_CHECK( nrf24_simRunUntil( test_payloadInFlight, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	nrf24_simRunUs( 1000 );
+
+	NRF24_CHECK( strcmp( test_events, "rtrtrt" ) == 0 );
+	for( i = 0; i < 3; i++ ){
+		NRF24_CHECK_EQ( nrf24_receive( data, &size, &pipe ), NRF24_OK );
+		NRF24_CHECK_EQ( size, sizeof(reply) );
+		NRF24_CHECK( memcmp( data, reply, sizeof(reply) ) == 0 );
+	}
+
+	// No payload frame was clocked by the CPU
+	for( i = 0; i < nrf24_simFrameCount(); i++ ){
+		frame = nrf24_simFrame( i );
+		if( frame->cmd == R_RX_PAYLOAD || frame->cmd == W_TX_PAYLOAD ){
+			NRF24_CHECK( frame->dma );
+		}
+	}
+
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.violations, 0 );
+	printf( "isr cycles %llu, polled from isr %u frames %u bytes, dma %u frames\n", (unsigned long long)stats.isr_cycles,
+		stats.isr_polled_frames, stats.isr_polled_bytes, stats.dma_frames );
+}
+#endif
+
+
+static const nrf24_test_t tests[] = {
+	{ "ack_before_tx_done", test_ackBeforeTxDone },
+	{ "flag_during_handler", test_flagDuringHandler },
+	{ "status_failure", test_statusFailure },
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	{ "payload_dma", test_payloadDma },
+#endif
+};
+
+int main( int argc, char** argv ){
+	return nrf24_testMain( tests, sizeof(tests) / sizeof(tests[0]), argc, argv );
+}
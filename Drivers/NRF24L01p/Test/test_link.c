@@ -0,0 +1,304 @@
+/*
+ * Host tests of the NRF24L01 library: initialization and a PTX/PRX link against the simulated peer
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include <string.h>
+
+
+static uint32_t test_rxReady;
+static uint32_t test_txDone;
+static uint32_t test_maxRt;
+
+static void test_onRxReady( uint8_t pipe ){
+	test_rxReady++;
+}
+
+static void test_onTxDone( void ){
+	test_txDone++;
+}
+
+static void test_onMaxRt( void ){
+	test_maxRt++;
+}
+
+static nrf24_event_callbacks_t test_callbacks = { test_onRxReady, test_onTxDone, test_onMaxRt };
+
+
+/* nrf24_Init writes the configuration and powers the chip up with CE high */
+static void test_initRegisters( void ){
+	nrf24_config_t config;
+	uint8_t address[NRF24_ADDR_MAX_WIDTH];
+	uint8_t frame[NRF24_ADDR_MAX_WIDTH + 1] = { R_REGISTER | NRF24_REG_TX_ADDR };
+	uint8_t reply[NRF24_ADDR_MAX_WIDTH + 1];
+	nrf24_sim_stats_t stats;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+
+	NRF24_CHECK( (nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_CONFIG ) >> NRF24_REG_CONFIG_PWR_UP_Pos) & 0b1u );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_RF_CH ), 76 );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_RF_SETUP ), nrf24_simReadReg( NRF24_SIM_PEER, NRF24_REG_RF_SETUP ) );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_FEATURE ), nrf24_simReadReg( NRF24_SIM_PEER, NRF24_REG_FEATURE ) );
+
+	nrf24_simCommand( NRF24_SIM_DUT, frame, reply, sizeof(frame) );
+	memcpy( address, &reply[1], sizeof(address) );
+	NRF24_CHECK( memcmp( address, config.tx_address, NRF24_ADDR_MAX_WIDTH ) == 0 );
+
+	NRF24_CHECK( (nrf24_simGpio( 2 )->ODR & NRF24_CE_PIN) != 0 );
+
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.violations, 0 );
+}
+
+/* Payloads queued back-to-back reach the peer in order, each one acknowledged */
+static void test_transmitAcked( void ){
+	nrf24_config_t config;
+	uint8_t payload[NRF24_MAX_PAYLOAD_SIZE], data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size, pipe, i;
+	nrf24_sim_stats_t stats;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+
+	for( i = 0; i < 3; i++ ){
+		memset( payload, 0xA0 + i, sizeof(payload) );
+		NRF24_CHECK_EQ( nrf24_transmit( payload, (uint8_t)(8u + i) ), NRF24_OK );
+	}
+
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	nrf24_simRunUs( 1000 );
+	NRF24_CHECK_EQ( test_txDone, 3 );
+	NRF24_CHECK_EQ( test_maxRt, 0 );
+
+	for( i = 0; i < 3; i++ ){
+		NRF24_CHECK( nrf24_testPeerReceive( data, &size, &pipe ) );
+		NRF24_CHECK_EQ( size, 8u + i );
+		NRF24_CHECK_EQ( pipe, 0 );
+		NRF24_CHECK_EQ( data[0], 0xA0 + i );
+	}
+
+	nrf24_simGetStats( &stats );
+	NRF24_CHECK_EQ( stats.violations, 0 );
+}
+
+/* An ACK payload queued on the peer comes back through the pipe #0 ring */
+static void test_ackPayload( void ){
+	nrf24_config_t config;
+	uint8_t reply[4] = { 1, 2, 3, 4 };
+	uint8_t payload[8] = { 0 };
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size, pipe;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+	nrf24_testPeerAckPayload( 0, reply, sizeof(reply) );
+
+	NRF24_CHECK_EQ( nrf24_transmit( payload, sizeof(payload) ), NRF24_OK );
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	nrf24_simRunUs( 1000 );
+
+	NRF24_CHECK_EQ( test_txDone, 1 );
+	NRF24_CHECK_EQ( test_rxReady, 1 );
+	NRF24_CHECK_EQ( nrf24_receive( data, &size, &pipe ), NRF24_OK );
+	NRF24_CHECK_EQ( size, sizeof(reply) );
+	NRF24_CHECK_EQ( pipe, 0 );
+	NRF24_CHECK( memcmp( data, reply, sizeof(reply) ) == 0 );
+}
+
+/* As PRX, a payload sent by the peer is drained into the ring and signalled */
+static void test_receive( void ){
+	nrf24_config_t config;
+	uint8_t payload[12] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2 };
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size, pipe;
+	nrf24_sim_radio_stats_t peer;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PRX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+
+	nrf24_testPeerSend( payload, sizeof(payload) );
+	nrf24_simRunUs( 1000 );
+
+	nrf24_simGetRadioStats( NRF24_SIM_PEER, &peer );
+	NRF24_CHECK_EQ( peer.tx_ds, 1 );
+	NRF24_CHECK_EQ( test_rxReady, 1 );
+	NRF24_CHECK_EQ( nrf24_receive( data, &size, &pipe ), NRF24_OK );
+	NRF24_CHECK_EQ( size, sizeof(payload) );
+	NRF24_CHECK( memcmp( data, payload, sizeof(payload) ) == 0 );
+}
+
+static uint8_t test_maxRtSeen( void ){
+	return test_maxRt > 0;
+}
+
+/* Nobody listening: ARC retransmits, then MAX_RT with the payload kept (retried once MAX_RT is cleared) */
+static void test_maxRetransmits( void ){
+	nrf24_config_t config;
+	uint8_t payload[8] = { 0 };
+	nrf24_sim_radio_stats_t dut;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+	nrf24_simSetCe( NRF24_SIM_PEER, 0 );
+
+	NRF24_CHECK_EQ( nrf24_transmit( payload, sizeof(payload) ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_maxRtSeen, NRF24_TEST_TIMEOUT_US ) );
+
+	nrf24_simGetRadioStats( NRF24_SIM_DUT, &dut );
+	NRF24_CHECK_EQ( test_txDone, 0 );
+	NRF24_CHECK_EQ( dut.air_packets, 16 );
+	NRF24_CHECK_EQ( nrf24_simTxLevel( NRF24_SIM_DUT ), 1 );
+}
+
+/* ARC_CNT is only sampled once the TX FIFO is empty, a MAX_RT payload is counted but not lost */
+static void test_linkStats( void ){
+	nrf24_config_t config;
+	uint8_t payload[8] = { 0 };
+	uint8_t i;
+	nrf24_link_stats_t stats;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+
+	// The first packet needs 2 retransmits, the other two are queued behind it
+	nrf24_simDropNext( NRF24_SIM_DUT, 2 );
+	for( i = 0; i < 3; i++ ){
+		NRF24_CHECK_EQ( nrf24_transmit( payload, sizeof(payload) ), NRF24_OK );
+	}
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	nrf24_simRunUs( 1000 );
+
+	nrf24_getLinkStats( &stats );
+	NRF24_CHECK_EQ( stats.sent, 3 );
+	NRF24_CHECK_EQ( stats.max_rt, 0 );
+	NRF24_CHECK( stats.retry_samples >= 1 && stats.retry_samples < 3 );
+	NRF24_CHECK_EQ( stats.retries, 0 );
+
+	// Nobody listening: MAX_RT after all ARC retransmits, the payload is still in the TX FIFO
+	nrf24_resetLinkStats();
+	nrf24_simSetCe( NRF24_SIM_PEER, 0 );
+	NRF24_CHECK_EQ( nrf24_transmit( payload, sizeof(payload) ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_maxRtSeen, NRF24_TEST_TIMEOUT_US ) );
+	nrf24_simRunUs( 100 );
+
+	nrf24_getLinkStats( &stats );
+	NRF24_CHECK_EQ( stats.sent, 0 );
+	NRF24_CHECK_EQ( stats.max_rt, 1 );
+	NRF24_CHECK_EQ( stats.retries, 15 );
+	NRF24_CHECK_EQ( stats.retry_samples, 1 );
+	NRF24_CHECK_EQ( nrf24_simTxLevel( NRF24_SIM_DUT ), 1 );
+}
+
+/* Without dynamic payload length only payloads of the static width are queued, the peer drops any other */
+static void test_staticWidth( void ){
+	nrf24_config_t config;
+	uint8_t payload[NRF24_MAX_PAYLOAD_SIZE] = { 0x42 };
+	uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size, pipe;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	config.dpl = NRF24_REG_FEATURE_EN_DPL_Val_DISABLE;
+	config.ack_pay = NRF24_REG_FEATURE_EN_ACK_PAY_Val_DISABLE;
+	config.payload_width = 8;
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+
+	NRF24_CHECK_EQ( nrf24_transmit( payload, 12 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_transmitNoAck( payload, 7 ), NRF24_ERR_PARAM );
+	NRF24_CHECK_EQ( nrf24_txPending(), 0 );
+	NRF24_CHECK_EQ( nrf24_getFaultCount( NRF24_FAULT_ASSERT ), 2 );
+
+	NRF24_CHECK_EQ( nrf24_transmit( payload, 8 ), NRF24_OK );
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	nrf24_simRunUs( 1000 );
+
+	NRF24_CHECK_EQ( test_txDone, 1 );
+	NRF24_CHECK( nrf24_testPeerReceive( data, &size, &pipe ) );
+	NRF24_CHECK_EQ( size, 8 );
+	NRF24_CHECK_EQ( data[0], 0x42 );
+}
+
+/*
+ * test_streamUs - Sends @packets payloads of NRF24_MAX_PAYLOAD_SIZE bytes to the draining peer
+ *
+ * uint32_t @packets:	# of payloads
+ * uint8_t @stream:		TRUE = keep the TX ring topped up, FALSE = wait for each TX_DS
+ *
+ * @return: simulated us from the first nrf24_transmit to the last TX_DS
+ */
+static uint32_t test_streamUs( uint32_t packets, uint8_t stream ){
+	uint8_t payload[NRF24_MAX_PAYLOAD_SIZE];
+	uint64_t start;
+	uint32_t i, done = test_txDone;
+	nrf24_err_t err;
+
+	start = nrf24_simNow();
+	for( i = 0; i < packets; i++ ){
+		memset( payload, (uint8_t)i, sizeof(payload) );
+		while( (err = nrf24_transmit( payload, sizeof(payload) )) == NRF24_ERR_FULL ){
+			nrf24_simRunUs( 10 );
+		}
+		NRF24_CHECK_EQ( err, NRF24_OK );
+
+		if( !stream ){
+			NRF24_CHECK( nrf24_testWaitIdle() );
+		}
+	}
+	NRF24_CHECK( nrf24_testWaitIdle() );
+	while( test_txDone != done + packets ){
+		NRF24_CHECK( nrf24_simNow() - start < nrf24_simUsToCycles( NRF24_TEST_TIMEOUT_US * 10u ) );
+		nrf24_simRunUs( 1 );
+	}
+
+	return (uint32_t)(((nrf24_simNow() - start) * 1000000u) / SystemCoreClock);
+}
+
+/* Streaming through the TX FIFO keeps the chip busy: the next payload is already loaded at TX_DS,
+ * no SPI/IRQ time between packets on top of TX settling and the ACK */
+static void test_streamThroughput( void ){
+	nrf24_config_t config;
+	uint32_t single_us, stream_us, single_pps, stream_pps;
+	nrf24_sim_radio_stats_t dut;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+	nrf24_simPeerAutoDrain( TRUE );
+
+	single_us = test_streamUs( 100, FALSE );
+	stream_us = test_streamUs( 100, TRUE );
+	single_pps = (100u * 1000000u) / single_us;
+	stream_pps = (100u * 1000000u) / stream_us;
+
+	printf( "2Mbps, 32 bytes: one at a time %u pps (%u bps), streamed %u pps (%u bps)\n",
+		single_pps, single_pps * NRF24_MAX_PAYLOAD_SIZE * 8u, stream_pps, stream_pps * NRF24_MAX_PAYLOAD_SIZE * 8u );
+
+	nrf24_simGetRadioStats( NRF24_SIM_DUT, &dut );
+	NRF24_CHECK_EQ( test_txDone, 200 );
+	NRF24_CHECK_EQ( dut.air_packets, 200 );
+	NRF24_CHECK( stream_pps > single_pps + single_pps / 16u );
+}
+
+
+static const nrf24_test_t tests[] = {
+	{ "init_registers", test_initRegisters },
+	{ "transmit_acked", test_transmitAcked },
+	{ "ack_payload", test_ackPayload },
+	{ "receive", test_receive },
+	{ "max_retransmits", test_maxRetransmits },
+	{ "link_stats", test_linkStats },
+	{ "static_width", test_staticWidth },
+	{ "stream_throughput", test_streamThroughput },
+};
+
+int main( int argc, char** argv ){
+	return nrf24_testMain( tests, sizeof(tests) / sizeof(tests[0]), argc, argv );
+}
@@ -0,0 +1,175 @@
+/*
+ * Host tests of the NRF24L01 library: the lock-free RX rings between nrf24_irqHandler and the
+ * application, under real concurrency (two threads) and end to end against the simulated chip
+ * The driver is included to reach the ring primitives the IRQ handler uses (static to it).
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include "../Src/nrf24l01p.c"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+
+#define TEST_SPSC_PAYLOADS    200000u
+#define TEST_LATENCY_SAMPLES  200u
+
+static uint32_t test_producerFull;
+static uint32_t test_rxReady;
+static uint64_t test_rxReadyAt;
+static uint64_t test_samples[TEST_LATENCY_SAMPLES];
+
+static void test_onRxReady( uint8_t pipe ){
+	test_rxReady++;
+	test_rxReadyAt = nrf24_simNow();
+}
+
+static nrf24_event_callbacks_t test_callbacks = { test_onRxReady, NULL, NULL };
+
+static uint64_t test_nowNs( void ){
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * test_producer - Plays nrf24_irqHandler: fills pipe #0's ring with numbered payloads whose
+ * size and content follow the number, spinning while it is full
+ */
+static void* test_producer( void* arg ){
+	uint32_t i, j;
+	uint8_t* slot;
+	uint8_t size;
+
+	for( i = 0; i < TEST_SPSC_PAYLOADS; i++ ){
+		// Yield so the consumer gets the core on single-CPU hosts
+		while( (slot = nrf24_ringReserve( &nrf24_rxRing[0] )) == NULL ){
+			test_producerFull++;
+			sched_yield();
+		}
+
+		size = (uint8_t)(4u + i % (NRF24_MAX_PAYLOAD_SIZE - 3u));
+		memcpy( slot, &i, sizeof(i) );
+		for( j = sizeof(i); j < size; j++ ){
+			slot[j] = (uint8_t)(i + j);
+		}
+		nrf24_ringCommit( &nrf24_rxRing[0], size, 0 );
+	}
+
+	return NULL;
+}
+
+/* A producer and a consumer thread hammer one ring: every payload arrives once, in order, intact */
+static void test_spscThreads( void ){
+	uint8_t buffer[NRF24_MAX_PAYLOAD_SIZE];
+	uint32_t i = 0, j, number, empty = 0;
+	uint8_t size;
+	uint64_t start, elapsed;
+	pthread_t producer;
+	nrf24_rx_stats_t stats;
+
+	start = test_nowNs();
+	NRF24_CHECK_EQ( pthread_create( &producer, NULL, test_producer, NULL ), 0 );
+
+	while( i < TEST_SPSC_PAYLOADS ){
+		if( nrf24_receiveFromPipe( 0, buffer, &size ) != NRF24_OK ){
+			empty++;
+			sched_yield();
+			continue;
+		}
+
+		memcpy( &number, buffer, sizeof(number) );
+		NRF24_CHECK_EQ( number, i );
+		NRF24_CHECK_EQ( size, 4u + i % (NRF24_MAX_PAYLOAD_SIZE - 3u) );
+		for( j = sizeof(number); j < size; j++ ){
+			NRF24_CHECK_EQ( buffer[j], (uint8_t)(i + j) );
+		}
+		i++;
+	}
+
+	pthread_join( producer, NULL );
+	elapsed = test_nowNs() - start;
+
+	NRF24_CHECK_EQ( nrf24_receiveFromPipe( 0, buffer, &size ), NRF24_ERR_EMPTY );
+	nrf24_getRxStats( 0, &stats );
+	NRF24_CHECK( stats.high_watermark <= NRF24_RING_SIZE );
+
+	printf( "%u payloads in %llu us (%llu ns each), producer found it full %u times, consumer empty %u times\n",
+		TEST_SPSC_PAYLOADS, (unsigned long long)(elapsed / 1000u), (unsigned long long)(elapsed / TEST_SPSC_PAYLOADS),
+		test_producerFull, empty );
+}
+
+static int test_compare( const void* a, const void* b ){
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * test_printLatency - Sorts the samples and prints their percentiles
+ *
+ * const char* @what:	label
+ *
+ * @return: max in us
+ */
+static uint32_t test_printLatency( const char* what ){
+	uint32_t us[4];
+	uint8_t percent[4] = { 50, 90, 99, 100 }, i;
+
+	qsort( test_samples, TEST_LATENCY_SAMPLES, sizeof(test_samples[0]), test_compare );
+	for( i = 0; i < 4; i++ ){
+		us[i] = (uint32_t)((test_samples[((TEST_LATENCY_SAMPLES - 1u) * percent[i]) / 100u] * 1000000u) / SystemCoreClock);
+	}
+
+	printf( "%s: p50 %u us, p90 %u us, p99 %u us, max %u us\n", what, us[0], us[1], us[2], us[3] );
+	return us[3];
+}
+
+/* Latency of a received payload: RX_DR on the chip to rx_ready, with the payload already in the ring */
+static void test_rxLatency( void ){
+	nrf24_config_t config;
+	uint8_t payload[NRF24_MAX_PAYLOAD_SIZE], buffer[NRF24_MAX_PAYLOAD_SIZE];
+	uint8_t size;
+	uint32_t i;
+	uint64_t raised;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PRX );
+	nrf24_testStart( &config );
+	nrf24_registerCallbacks( &test_callbacks );
+
+	for( i = 0; i < TEST_LATENCY_SAMPLES; i++ ){
+		memset( payload, (uint8_t)i, sizeof(payload) );
+
+		// Let the previous SysTick/handler run settle at a different phase each time
+		nrf24_simRunUs( 100u + i % 37u );
+		NRF24_CHECK( nrf24_simInjectRx( NRF24_SIM_DUT, 0, payload, sizeof(payload) ) );
+		nrf24_simRaise( NRF24_SIM_DUT, 0b1u << NRF24_REG_STATUS_RX_DR_Pos );
+		raised = nrf24_simNow();
+
+		while( test_rxReady == i ){
+			NRF24_CHECK( nrf24_simNow() - raised < nrf24_simUsToCycles( 1000 ) );
+			nrf24_simStep( 1 );
+		}
+		test_samples[i] = test_rxReadyAt - raised;
+
+		NRF24_CHECK_EQ( nrf24_receiveFromPipe( 0, buffer, &size ), NRF24_OK );
+		NRF24_CHECK_EQ( size, sizeof(payload) );
+		NRF24_CHECK( memcmp( buffer, payload, sizeof(payload) ) == 0 );
+	}
+
+	// STATUS, R_RX_PL_WID and 33 bytes of R_RX_PAYLOAD at 5.25Mbit/s are ~70us on the wire
+	NRF24_CHECK( test_printLatency( "RX_DR to rx_ready" ) < 150u );
+}
+
+
+static const nrf24_test_t tests[] = {
+	{ "spsc_threads", test_spscThreads },
+	{ "rx_latency", test_rxLatency },
+};
+
+int main( int argc, char** argv ){
+	return nrf24_testMain( tests, sizeof(tests) / sizeof(tests[0]), argc, argv );
+}
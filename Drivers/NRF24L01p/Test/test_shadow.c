@@ -0,0 +1,146 @@
+/*
+ * Host tests of the NRF24L01 library: the shadow register copy only records values the chip accepted
+ */
+
+
+/* Header file */
+#include "nrf24_test.h"
+#include <string.h>
+
+
+static uint32_t test_callbacks;
+
+static void test_onDone( nrf24_err_t err, uint8_t status ){
+	test_callbacks++;
+}
+
+static uint8_t test_idle( void ){
+	return !nrf24_isBusy() && nrf24_cmdPending() == 0;
+}
+
+static void test_initDut( void ){
+	nrf24_config_t config;
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	nrf24_testStart( &config );
+}
+
+/* Fails the next frame that reaches the bus, whichever way it is clocked */
+static void test_failNextFrame( uint8_t async ){
+#if NRF24_SPI_TRANSPORT == NRF24_SPI_TRANSPORT_DMA
+	if( async ){
+		nrf24_simFailDmaTransfer( 0, 1 );
+		return;
+	}
+#endif
+	nrf24_simFailSpi( 0, 1, HAL_ERROR );
+}
+
+/*
+ * test_readCachedMiss - Reads RF_CH through the cache and checks it came from the chip
+ *
+ * uint8_t @expected: value the chip holds
+ *
+ * @return: void
+ */
+static void test_readCachedMiss( uint8_t expected ){
+	nrf24_shadow_stats_t before, after;
+	uint8_t value = 0;
+
+	nrf24_getShadowStats( &before );
+	NRF24_CHECK_EQ( nrf24_readRegCached( NRF24_REG_RF_CH, &value, 1 ), NRF24_OK );
+	nrf24_getShadowStats( &after );
+
+	NRF24_CHECK_EQ( after.misses, before.misses + 1 );
+	NRF24_CHECK_EQ( value, expected );
+}
+
+
+/* A failed nrf24_writeReg leaves the register unknown instead of caching the value that never arrived */
+static void test_writeFailure( void ){
+	uint8_t value = 20;
+
+	test_initDut();
+
+	test_failNextFrame( FALSE );
+	NRF24_CHECK( nrf24_writeReg( NRF24_REG_RF_CH, &value, 1 ) != NRF24_OK );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_RF_CH ), 76 );
+
+	test_readCachedMiss( 76 );
+}
+
+/* Asynchronous writes are recorded by their completion, a failed transfer is forgotten */
+static void test_asyncWrite( void ){
+	nrf24_shadow_stats_t before, after;
+	uint8_t value = 30;
+
+	test_initDut();
+
+	NRF24_CHECK_EQ( nrf24_writeRegAsync( NRF24_REG_RF_CH, &value, 1, test_onDone ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_idle, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK_EQ( test_callbacks, 1 );
+
+	nrf24_getShadowStats( &before );
+	value = 0;
+	NRF24_CHECK_EQ( nrf24_readRegCached( NRF24_REG_RF_CH, &value, 1 ), NRF24_OK );
+	nrf24_getShadowStats( &after );
+	NRF24_CHECK_EQ( after.hits, before.hits + 1 );
+	NRF24_CHECK_EQ( value, 30 );
+
+	value = 40;
+	test_failNextFrame( TRUE );
+	nrf24_writeRegAsync( NRF24_REG_RF_CH, &value, 1, test_onDone );
+	NRF24_CHECK( nrf24_simRunUntil( test_idle, NRF24_TEST_TIMEOUT_US ) );
+
+	test_readCachedMiss( 30 );
+}
+
+/* Same for commands submitted to the queue */
+static void test_submitWrite( void ){
+	uint8_t value = 50;
+	uint32_t frames;
+
+	test_initDut();
+
+	test_failNextFrame( TRUE );
+	nrf24_submitCmd( W_REGISTER | NRF24_REG_RF_CH, &value, NULL, 1, test_onDone );
+	NRF24_CHECK( nrf24_simRunUntil( test_idle, NRF24_TEST_TIMEOUT_US ) );
+
+	test_readCachedMiss( 76 );
+
+	NRF24_CHECK_EQ( nrf24_submitCmd( W_REGISTER | NRF24_REG_RF_CH, &value, NULL, 1, test_onDone ), NRF24_OK );
+	NRF24_CHECK( nrf24_simRunUntil( test_idle, NRF24_TEST_TIMEOUT_US ) );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_RF_CH ), 50 );
+
+	// Recorded on completion: writing the same value again is skipped
+	frames = nrf24_simFrameCount();
+	NRF24_CHECK_EQ( nrf24_writeRegCached( NRF24_REG_RF_CH, &value, 1 ), NRF24_OK );
+	NRF24_CHECK_EQ( nrf24_simFrameCount(), frames );
+}
+
+/* nrf24_Init after the chip lost its registers (brown-out) writes everything again */
+static void test_initAfterReset( void ){
+	nrf24_config_t config;
+	uint8_t value = 2;
+
+	test_initDut();
+
+	// Reset value behind the driver's back, the shadow copy still holds 76
+	nrf24_simWriteReg( NRF24_SIM_DUT, NRF24_REG_RF_CH, &value, 1 );
+
+	nrf24_testConfig( &config, NRF24_REG_CONFIG_PRIM_RX_Val_PTX );
+	NRF24_CHECK_EQ( nrf24_Init( &config ), NRF24_OK );
+	NRF24_CHECK_EQ( nrf24_simReadReg( NRF24_SIM_DUT, NRF24_REG_RF_CH ), 76 );
+}
+
+
+static const nrf24_test_t tests[] = {
+	{ "write_failure", test_writeFailure },
+	{ "async_write", test_asyncWrite },
+	{ "submit_write", test_submitWrite },
+	{ "init_after_reset", test_initAfterReset },
+};
+
+int main( int argc, char** argv ){
+	return nrf24_testMain( tests, sizeof(tests) / sizeof(tests[0]), argc, argv );
+}